@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    ChannelGroupPool.h
+
+    A small pool of real-time worker threads that process groups of channels
+    in parallel with the audio thread.
+
+    The audio thread publishes a job by storing a new generation together
+    with the number of groups in one atomic word. It runs group 0 itself,
+    then claims whatever groups no worker has picked up yet and spins until
+    the claimed ones are done. Workers claim groups from the same word, so a
+    worker that is late or parked never holds the audio thread up.
+
+    Workers spin while the pool is active and the audio thread keeps calling
+    setActive(true) once per block. If no block arrives within the idle
+    timeout (host stopped calling processBlock, track suspended) or the pool
+    is deactivated, they park in short sleeps until the next block. No mutex
+    or event is ever taken.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+#include <thread>
+
+class ChannelGroupPool
+{
+public:
+    explicit ChannelGroupPool(int numWorkersToUse)
+    {
+        for (int i = 0; i < numWorkersToUse; ++i)
+            workers.add(new Worker(*this, i + 1));
+
+        for (auto* worker : workers)
+            if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions{}))
+                worker->startThread(juce::Thread::Priority::highest);
+    }
+
+    ~ChannelGroupPool()
+    {
+        active.store(false, std::memory_order_release);
+
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        for (auto* worker : workers)
+            worker->stopThread(1000);
+    }
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    /** Workers park once this long has passed without a call to
+        setActive(true). Set it to a couple of host block periods.
+    */
+    void setIdleTimeout(double seconds) noexcept
+    {
+        idleTimeoutTicks.store(juce::Time::secondsToHighResolutionTicks(seconds), std::memory_order_relaxed);
+    }
+
+    /** Called from the audio thread once per block. While it keeps being
+        called with true the workers spin, otherwise they park.
+    */
+    void setActive(bool shouldBeActive) noexcept
+    {
+        active.store(shouldBeActive, std::memory_order_release);
+
+        if (shouldBeActive)
+            heartbeat.fetch_add(1, std::memory_order_release);
+    }
+
+    /** True once every worker is spinning and a job would start without delay. */
+    bool isReady() const noexcept
+    {
+        return active.load(std::memory_order_acquire)
+            && numSpinning.load(std::memory_order_acquire) == workers.size();
+    }
+
+    /** Calls callback(group) for groups [0, numGroups), group 0 on the calling
+        thread, and returns once every group is done. Groups no worker claims
+        in time run on the calling thread too. Call it with
+        numGroups <= getNumWorkers() + 1.
+    */
+    template <typename Callback>
+    void run(int numGroups, Callback& callback) noexcept
+    {
+        jassert(numGroups <= workers.size() + 1);
+
+        job = [](void* context, int group) { (*static_cast<Callback*>(context))(group); };
+        jobContext = &callback;
+        groupsDone.store(0, std::memory_order_relaxed);
+
+        const auto generation = jobGeneration(jobState.load(std::memory_order_relaxed)) + 1;
+        jobState.store(makeJobState(generation, 1, numGroups), std::memory_order_release);
+
+        callback(0);
+
+        auto doneHere = 0;
+        for (int group; (group = claimGroup(generation)) > 0; ++doneHere)
+            callback(group);
+
+        for (int spins = 0; groupsDone.load(std::memory_order_acquire) + doneHere != numGroups - 1; ++spins)
+            if (spins > spinsBeforeYield)
+                std::this_thread::yield();
+    }
+
+private:
+    static constexpr int spinsBeforeYield = 64;
+    static constexpr int parkedSleepMs = 2;
+
+    // Generation in the top 32 bits, next unclaimed group and the group
+    // count in 16 bits each
+    static uint64_t makeJobState(uint32_t generation, int nextGroup, int numGroups) noexcept
+    {
+        return ((uint64_t) generation << 32) | ((uint64_t) nextGroup << 16) | (uint64_t) numGroups;
+    }
+
+    static uint32_t jobGeneration(uint64_t state) noexcept { return (uint32_t) (state >> 32); }
+    static int jobNextGroup(uint64_t state) noexcept { return (int) ((state >> 16) & 0xffff); }
+    static int jobNumGroups(uint64_t state) noexcept { return (int) (state & 0xffff); }
+
+    /** Claims the next group of the given job, or returns 0 when the job has
+        no unclaimed groups left or has been replaced.
+    */
+    int claimGroup(uint32_t generation) noexcept
+    {
+        auto state = jobState.load(std::memory_order_acquire);
+
+        for (;;) {
+            const auto group = jobNextGroup(state);
+
+            if (jobGeneration(state) != generation || group >= jobNumGroups(state))
+                return 0;
+
+            if (jobState.compare_exchange_weak(state, makeJobState(generation, group + 1, jobNumGroups(state)),
+                                               std::memory_order_acq_rel, std::memory_order_acquire))
+                return group;
+        }
+    }
+
+    struct Worker : juce::Thread
+    {
+        Worker(ChannelGroupPool& p, int workerIndex)
+            : juce::Thread("Envelope channel group " + juce::String(workerIndex)), pool(p)
+        {
+        }
+
+        void run() override
+        {
+            auto seen = jobGeneration(pool.jobState.load(std::memory_order_acquire));
+            auto lastBeat = pool.heartbeat.load(std::memory_order_acquire);
+            auto lastBeatTicks = juce::Time::getHighResolutionTicks();
+            bool spinning = false;
+
+            while (!threadShouldExit()) {
+                const auto generation = jobGeneration(pool.jobState.load(std::memory_order_acquire));
+
+                if (generation != seen) {
+                    seen = generation;
+
+                    juce::ScopedNoDenormals noDenormals;
+
+                    for (int group; (group = pool.claimGroup(generation)) > 0;) {
+                        pool.job(pool.jobContext, group);
+                        pool.groupsDone.fetch_add(1, std::memory_order_release);
+                    }
+
+                    continue;
+                }
+
+                // Keep spinning only while blocks keep arriving
+                const auto now = juce::Time::getHighResolutionTicks();
+                const auto beat = pool.heartbeat.load(std::memory_order_acquire);
+
+                if (beat != lastBeat) {
+                    lastBeat = beat;
+                    lastBeatTicks = now;
+                }
+
+                const auto shouldSpin = pool.active.load(std::memory_order_acquire)
+                                     && now - lastBeatTicks < pool.idleTimeoutTicks.load(std::memory_order_relaxed);
+
+                if (shouldSpin != spinning) {
+                    spinning = shouldSpin;
+                    pool.numSpinning.fetch_add(spinning ? 1 : -1, std::memory_order_acq_rel);
+                }
+
+                if (!spinning) {
+                    juce::Thread::sleep(parkedSleepMs);
+                    continue;
+                }
+
+                for (int spins = 0; spins < spinsBeforeYield; ++spins)
+                    if (jobGeneration(pool.jobState.load(std::memory_order_acquire)) != seen)
+                        break;
+
+                if (jobGeneration(pool.jobState.load(std::memory_order_acquire)) == seen)
+                    std::this_thread::yield();
+            }
+
+            if (spinning)
+                pool.numSpinning.fetch_sub(1, std::memory_order_release);
+        }
+
+        ChannelGroupPool& pool;
+    };
+
+    juce::OwnedArray<Worker> workers;
+
+    std::atomic<bool> active{ false };
+    std::atomic<uint32_t> heartbeat{ 0 };
+    std::atomic<juce::int64> idleTimeoutTicks{ juce::Time::secondsToHighResolutionTicks(0.01) };
+    std::atomic<int> numSpinning{ 0 }, groupsDone{ 0 };
+    std::atomic<uint64_t> jobState{ 0 };
+
+    // Written by the audio thread before the job state is published
+    void (*job)(void*, int) = nullptr;
+    void* jobContext = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelGroupPool)
+};
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    ChannelState.h
+
+    Running state of every channel in one contiguous, cache-line aligned
+    struct-of-arrays block: the envelope, the filter state, the filter
+    coefficients currently in use and the last input of the drive stage,
+    before the drive gain.
+    Filter state and coefficients are the generic slots of FilterPolicies.
+
+    Each field is an array with one entry per channel. Channels are stored in
+    runs of runChannels, and every run starts on a cache line of its own, so a
+    group of channels starting on a multiple of runChannels never shares a line
+    with another group. Channel groups processed on different threads therefore
+    never write to the same line, however few channels each of them holds.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterPolicies.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+template <typename FloatType>
+class ChannelStateBlock
+{
+public:
+    static constexpr int cacheLineBytes = 64;
+    static constexpr int cacheLineChannels = cacheLineBytes / (int) sizeof(FloatType);
+
+    // Channels per run, the granularity channel groups are aligned to
+    static constexpr int runChannels = 4;
+
+    /** Sizes the block for numChannels and clears it. Allocates, so call it
+        from prepareToPlay only.
+    */
+    void prepare(int numChannels)
+    {
+        channels = numChannels;
+        stride = ((numChannels > 0 ? numChannels : 1) + runChannels - 1) / runChannels * runStride;
+
+        storage.assign((size_t) (stride * numFields + cacheLineChannels), FloatType(0));
+
+        const auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+        const auto misalignment = (int) (address % cacheLineBytes);
+        auto* base = storage.data() + (misalignment == 0 ? 0 : (cacheLineBytes - misalignment) / (int) sizeof(FloatType));
+
+        envelopes = base;
+        driveInputs = base + stride;
+
+        for (int i = 0; i < FilterPolicies::maxStates; ++i)
+            filterState[i] = base + (2 + i) * stride;
+
+        for (int i = 0; i < FilterPolicies::maxCoefficients; ++i)
+            coefficients[i] = base + (2 + FilterPolicies::maxStates + i) * stride;
+
+        reset();
+    }
+
+    /** Zeroes the envelopes, filter and drive state and sets every peak filter
+        to pass-through.
+    */
+    void reset() noexcept
+    {
+        std::fill(envelopes, envelopes + stride * numFields, FloatType(0));
+        std::fill(coefficients[0], coefficients[0] + stride, FloatType(1));
+    }
+
+    /** Zeroes the filter state only, for a change of filter type. */
+    void resetFilterState() noexcept
+    {
+        std::fill(filterState[0], filterState[0] + stride * FilterPolicies::maxStates, FloatType(0));
+    }
+
+    void setCoefficients(int channel, const FilterPolicies::Coefficients<FloatType>& c) noexcept
+    {
+        for (int i = 0; i < FilterPolicies::maxCoefficients; ++i)
+            coefficients[i][slot(channel)] = c[(size_t) i];
+    }
+
+    FilterPolicies::Coefficients<FloatType> getCoefficients(int channel) const noexcept
+    {
+        FilterPolicies::Coefficients<FloatType> c;
+
+        for (int i = 0; i < FilterPolicies::maxCoefficients; ++i)
+            c[(size_t) i] = coefficients[i][slot(channel)];
+
+        return c;
+    }
+
+    /** Copies the first numStates state slots of a channel into state. */
+    template <int numStates>
+    void loadFilterState(int channel, FilterPolicies::State<FloatType>& state) const noexcept
+    {
+        for (int i = 0; i < numStates; ++i)
+            state[(size_t) i] = filterState[i][slot(channel)];
+    }
+
+    template <int numStates>
+    void storeFilterState(int channel, const FilterPolicies::State<FloatType>& state) noexcept
+    {
+        for (int i = 0; i < numStates; ++i)
+            filterState[i][slot(channel)] = state[(size_t) i];
+    }
+
+    FloatType& envelope(int channel) noexcept { return envelopes[slot(channel)]; }
+    FloatType& driveInput(int channel) noexcept { return driveInputs[slot(channel)]; }
+
+    int getNumChannels() const noexcept { return channels; }
+
+    // Envelope follower coefficients, shared by all channels and written once
+    // per block before any channel is processed
+    alignas(cacheLineBytes) FloatType attack{ 0 };
+    FloatType release{ 0 };
+
+private:
+    // A run padded to a whole number of cache lines
+    static constexpr int runStride = (runChannels + cacheLineChannels - 1) / cacheLineChannels * cacheLineChannels;
+
+    static constexpr int numFields = 2 + FilterPolicies::maxStates + FilterPolicies::maxCoefficients;
+
+    static int slot(int channel) noexcept
+    {
+        return channel / runChannels * runStride + channel % runChannels;
+    }
+
+    FloatType* envelopes = nullptr;
+    FloatType* driveInputs = nullptr;
+    FloatType* filterState[FilterPolicies::maxStates]{};
+    FloatType* coefficients[FilterPolicies::maxCoefficients]{};
+
+    std::vector<FloatType> storage;
+    int channels{ 0 }, stride{ 0 };
+};
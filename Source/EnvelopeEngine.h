@@ -0,0 +1,406 @@
+/*
+  ==============================================================================
+
+    EnvelopeEngine.h
+
+    The envelope filter on its own: level detector, envelope follower,
+    control-rate modulation and coefficient design, drive and filter, run in
+    place over raw channel pointers.
+
+    Header-only and free of JUCE, it needs nothing but the C++17 standard
+    library. prepare() allocates, nothing after it does. The plugin wraps one
+    engine per quality level, EnvelopeEngineC.h exposes it to C.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ChannelState.h"
+#include "LevelDetector.h"
+#include "Modulation.h"
+#include "Saturation.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+/** Everything the engine reads per block. Times are in seconds, frequencies
+    in Hz, gain and drive are linear.
+*/
+struct EnvelopeParameters
+{
+    float gainFactor{ 6.f }, qFactor{ 3.f }, dryWetMix{ 1.f },
+        attackTime{ 0.001f }, releaseTime{ 0.080f }, bandStart{ 250.f }, bandWidth{ 1000.f },
+        rmsWindow{ 0.050f }, drive{ 1.f };
+    FilterType filterType{ FilterType::Peak };
+    DrivePosition drivePosition{ DrivePosition::Off };
+    DetectorMode detectorMode{ DetectorMode::Peak };
+    ModMatrix modMatrix{ { { 1.f, 0.f, 0.f }, {}, {} } };
+};
+
+/** The first channel's filter settings, published by the audio thread on every
+    control tick and read by the editor without locking. A version counter that
+    is odd while a write is in progress makes a torn read detectable. The
+    version only moves when the settings do, so a reader can redraw on a
+    change of version alone.
+*/
+struct FilterSnapshot
+{
+    struct Values
+    {
+        float cutoff{ 1000.f }, q{ 3.f }, gain{ 6.f };
+    };
+
+    void publish(const Values& values) noexcept
+    {
+        // Only the audio thread writes, it can compare against its own last write
+        if (values.cutoff == cutoff.load(std::memory_order_relaxed)
+            && values.q == q.load(std::memory_order_relaxed)
+            && values.gain == gain.load(std::memory_order_relaxed))
+            return;
+
+        const auto v = version.load(std::memory_order_relaxed);
+        version.store(v + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        cutoff.store(values.cutoff, std::memory_order_relaxed);
+        q.store(values.q, std::memory_order_relaxed);
+        gain.store(values.gain, std::memory_order_relaxed);
+
+        version.store(v + 2, std::memory_order_release);
+    }
+
+    /** Returns false if a write was in progress, try again on the next frame. */
+    bool read(Values& values, uint32_t& readVersion) const noexcept
+    {
+        const auto v = version.load(std::memory_order_acquire);
+
+        if ((v & 1) != 0)
+            return false;
+
+        values.cutoff = cutoff.load(std::memory_order_relaxed);
+        values.q = q.load(std::memory_order_relaxed);
+        values.gain = gain.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        readVersion = v;
+        return version.load(std::memory_order_relaxed) == v;
+    }
+
+private:
+    std::atomic<float> cutoff{ 1000.f }, q{ 3.f }, gain{ 6.f };
+    std::atomic<uint32_t> version{ 0 };
+};
+
+/** Modulation sources besides the envelope, owned by the caller. A missing
+    LFO reads as zero.
+*/
+struct ModulationSources
+{
+    const TempoSyncedLfo* lfo = nullptr;
+    float velocity = 0.f;
+};
+
+template <typename FloatType>
+class EnvelopeEngine
+{
+public:
+    // All channels are run over one micro-block of at most this many samples
+    // before moving on to the next
+    static constexpr int microBlockSize = 32;
+
+    /** Sizes every buffer for numChannels and clears the state. Allocates.
+
+        The engine runs at hostSampleRate * oversamplingFactor, the caller
+        resamples. Coefficients and modulation are updated every
+        controlInterval engine samples, on a grid that carries on across blocks.
+    */
+    void prepare(double hostSampleRate, int numChannels, int controlInterval,
+                 int oversamplingFactor = 1, double maxRmsWindowSeconds = 0.3)
+    {
+        sampleRate = hostSampleRate * oversamplingFactor;
+        factor = oversamplingFactor;
+        interval = controlInterval;
+        channelState.prepare(numChannels);
+        levelDetector.prepare(sampleRate, numChannels, maxRmsWindowSeconds);
+        samplesUntilControlTick = 0;
+       #if ENVELOPE_ENABLE_TRACE
+        samplesUntilTrace = 0;
+       #endif
+    }
+
+    /** Clears every piece of running state. */
+    void reset() noexcept
+    {
+        channelState.reset();
+        levelDetector.reset();
+        samplesUntilControlTick = 0;
+       #if ENVELOPE_ENABLE_TRACE
+        samplesUntilTrace = 0;
+       #endif
+    }
+
+    /** Channel 0 publishes its filter settings here on every control tick. */
+    void setSnapshot(FilterSnapshot* newSnapshot) noexcept { snapshot = newSnapshot; }
+
+   #if ENVELOPE_ENABLE_TRACE
+    /** Channel 0 pushes a record here on the control tick that falls on or
+        after every hostInterval host samples. An engine updating more often
+        than that, like an oversampled one with per-sample coefficients, is
+        traced on the same grid as the others and cannot flood the ring.
+    */
+    void setTrace(TraceRing* newTrace, int hostInterval) noexcept
+    {
+        trace = newTrace;
+        traceInterval = hostInterval;
+    }
+   #endif
+
+    int getNumChannels() const noexcept { return channelState.getNumChannels(); }
+    double getSampleRate() const noexcept { return sampleRate; }
+    int getOversamplingFactor() const noexcept { return factor; }
+
+    /** Processes one block of every channel in place. */
+    void process(FloatType* const* channelData, int numSamples,
+                 const EnvelopeParameters& parameters, const ModulationSources& sources = {}) noexcept
+    {
+        beginBlock(parameters);
+        processChannels(channelData, numSamples, 0, 0, getNumChannels(), parameters, sources);
+        endBlock(numSamples);
+    }
+
+    // The same in steps, for callers that split a block across threads or
+    // into chunks: beginBlock() once, processChannels() for every range of
+    // channels and chunk of samples, endBlock() after each chunk. blockOffset
+    // is where the chunk starts, in engine samples from the start of the block.
+
+    void beginBlock(const EnvelopeParameters& parameters) noexcept
+    {
+        // Envelope time constants only change with the parameters
+        const auto rate = (FloatType) sampleRate;
+        channelState.attack = FilterDesign::makeTimeConstant((FloatType) parameters.attackTime, rate);
+        channelState.release = FilterDesign::makeTimeConstant((FloatType) parameters.releaseTime, rate);
+
+        levelDetector.setRmsWindow(parameters.rmsWindow);
+
+        // Another filter type reads the coefficient and state slots differently:
+        // clear the state and tick on the first sample so coefficients are
+        // designed before they are used
+        if (parameters.filterType != filterType) {
+            filterType = parameters.filterType;
+            channelState.resetFilterState();
+            samplesUntilControlTick = 0;
+        }
+    }
+
+    void processChannels(FloatType* const* channelData, int numSamples, int blockOffset, int firstChannel, int lastChannel,
+                         const EnvelopeParameters& parameters, const ModulationSources& sources) noexcept
+    {
+        // The detector mode and filter type are resolved once per block, each
+        // combination gets its own loop
+        withFilterPolicy(parameters.filterType, [&](auto filter)
+            {
+                using Filter = decltype(filter);
+
+                switch (parameters.detectorMode)
+                {
+                    case DetectorMode::Peak:     processRange<DetectorMode::Peak, Filter>(channelData, numSamples, blockOffset, firstChannel, lastChannel, parameters, sources); break;
+                    case DetectorMode::Rms:      processRange<DetectorMode::Rms, Filter>(channelData, numSamples, blockOffset, firstChannel, lastChannel, parameters, sources); break;
+                    case DetectorMode::TruePeak: processRange<DetectorMode::TruePeak, Filter>(channelData, numSamples, blockOffset, firstChannel, lastChannel, parameters, sources); break;
+                }
+            });
+    }
+
+    void endBlock(int numSamples) noexcept
+    {
+        // Carry the control grid over into the next block
+        samplesUntilControlTick = samplesUntilTickAfter(samplesUntilControlTick, numSamples, interval);
+    }
+
+private:
+    ChannelStateBlock<FloatType> channelState;
+    LevelDetector<FloatType> levelDetector;
+    FilterSnapshot* snapshot = nullptr;
+   #if ENVELOPE_ENABLE_TRACE
+    TraceRing* trace = nullptr;
+    int traceInterval{ 1 }, samplesUntilTrace{ 0 };
+   #endif
+    double sampleRate{ 44100.0 };
+    int factor{ 1 };
+    int interval{ 1 };
+    int samplesUntilControlTick{ 0 };
+    FilterType filterType{ FilterType::Peak };
+
+    static int samplesUntilTickAfter(int untilTick, int numSamples, int tickInterval) noexcept
+    {
+        return untilTick >= numSamples
+            ? untilTick - numSamples
+            : (tickInterval - (numSamples - untilTick) % tickInterval) % tickInterval;
+    }
+
+    template <typename Filter>
+    void updateFilter(int channel, int sampleOffset, const EnvelopeParameters& parameters, const ModulationSources& sources) noexcept
+    {
+        static constexpr float ln4 = 1.38629436f;
+
+        const float values[numModSources] = { (float) channelState.envelope(channel),
+                                              sources.lfo != nullptr ? sources.lfo->valueAt((double) sampleOffset / factor) : 0.f,
+                                              sources.velocity };
+        float mod[numModDestinations];
+        parameters.modMatrix.evaluate(values, mod);
+
+        // Cutoff sweeps across the band, Q moves by up to two octaves either way,
+        // gain scales the boost of the peak or the drive of the ladder
+        auto fc = parameters.bandStart + parameters.bandWidth * mod[modCutoff];
+        auto q = std::clamp(parameters.qFactor * DspMath::exp(mod[modQ] * ln4), 0.1f, 10.f);
+        auto gain = std::clamp(parameters.gainFactor + (parameters.gainFactor - 1.f) * mod[modGain], 1.f, 30.f);
+
+        channelState.setCoefficients(channel, Filter::design((FloatType) sampleRate, (FloatType) fc, (FloatType) q, (FloatType) gain));
+
+        // Channel 0 is always processed on the calling thread, it feeds the editor
+        if (channel == 0 && snapshot != nullptr)
+            snapshot->publish({ fc, q, gain });
+
+       #if ENVELOPE_ENABLE_TRACE
+        if (channel == 0 && trace != nullptr) {
+            if (samplesUntilTrace <= 0) {
+                samplesUntilTrace += traceInterval * factor;
+                traceTick(sampleOffset, values[modEnvelope], fc, q, gain, parameters);
+            }
+
+            samplesUntilTrace -= interval;
+        }
+       #endif
+    }
+
+   #if ENVELOPE_ENABLE_TRACE
+    void traceTick(int sampleOffset, float envelope, float fc, float q, float gain, const EnvelopeParameters& parameters) noexcept
+    {
+        TraceRecord record{};
+
+        record.tickOffset = (uint32_t) sampleOffset;
+        record.envelope = envelope;
+        record.cutoff = fc;
+        record.q = q;
+        record.gain = gain;
+
+        record.gainFactor = parameters.gainFactor;
+        record.qFactor = parameters.qFactor;
+        record.bandStart = parameters.bandStart;
+        record.bandWidth = parameters.bandWidth;
+        record.attackTime = parameters.attackTime;
+        record.releaseTime = parameters.releaseTime;
+        record.dryWetMix = parameters.dryWetMix;
+        record.drive = parameters.drive;
+
+        record.filterType = (uint8_t) parameters.filterType;
+        record.detectorMode = (uint8_t) parameters.detectorMode;
+        record.drivePosition = (uint8_t) parameters.drivePosition;
+
+        trace->push(record);
+    }
+   #endif
+
+    template <DetectorMode mode, typename Filter>
+    void processRange(FloatType* const* channelData, int numSamples, int blockOffset, int firstChannel, int lastChannel,
+                      const EnvelopeParameters& parameters, const ModulationSources& sources) noexcept
+    {
+        const auto mix = (FloatType) parameters.dryWetMix;
+        const auto aa = channelState.attack;
+        const auto ar = channelState.release;
+        const auto one = FloatType(1);
+
+        // The drive position is constant for the block, the branches below never mispredict
+        const auto drivePosition = parameters.drivePosition;
+        const auto drive = (double) parameters.drive;
+
+        // Work through the block one micro-block at a time, running every channel
+        // over it before moving on, so the detector, coefficients and filter state
+        // of all channels stay in cache whatever the block size. Micro-blocks
+        // end on control ticks, a partial one first realigns to the grid.
+        int blockStart = 0;
+        int blockUntilTick = samplesUntilControlTick;
+
+        while (blockStart < numSamples) {
+            const auto blockEnd = blockStart + std::min({ numSamples - blockStart, microBlockSize,
+                                                          blockUntilTick > 0 ? blockUntilTick : microBlockSize });
+
+            for (int channel = firstChannel; channel < lastChannel; ++channel) {
+                FloatType* data = channelData[channel];
+
+                // Keep the channel's running state in registers for the micro-block
+                FloatType envelope = channelState.envelope(channel);
+                FilterPolicies::State<FloatType> state;
+                channelState.template loadFilterState<Filter::numStates>(channel, state);
+
+                // The drive stage's last input is kept before the drive gain,
+                // exact in FloatType, so restoring the shaper at the start of a
+                // micro-block changes nothing and the output does not depend
+                // on where the host's blocks end
+                Saturation::AdaaTanh shaper;
+                FloatType driveInput = channelState.driveInput(channel);
+                if (drivePosition != DrivePosition::Off)
+                    shaper.setState(drive * driveInput);
+
+                int sample = blockStart;
+                int untilTick = blockUntilTick;
+
+                while (sample < blockEnd) {
+                    if (untilTick == 0) {
+                        channelState.envelope(channel) = envelope;
+                        updateFilter<Filter>(channel, blockOffset + sample, parameters, sources);
+                        untilTick = interval;
+                    }
+
+                    const auto segmentEnd = std::min(blockEnd, sample + untilTick);
+                    untilTick -= segmentEnd - sample;
+
+                    const auto coefficients = channelState.getCoefficients(channel);
+
+                    for (; sample < segmentEnd; ++sample) {
+
+                        const FloatType in = data[sample];
+
+                        // Level detector
+                        const FloatType level = levelDetector.template process<mode>(channel, in);
+
+                        // Envelope
+                        if (level > envelope) {
+                            envelope = aa * envelope + (one - aa) * level;
+                        }
+                        else {
+                            envelope = ar * envelope + (one - ar) * level;
+                        }
+
+                        FloatType x = in;
+
+                        if (drivePosition == DrivePosition::PreFilter) {
+                            driveInput = x;
+                            x = (FloatType) shaper.process(drive * x);
+                        }
+
+                        FloatType filtered = Filter::process(coefficients, state, x);
+
+                        if (drivePosition == DrivePosition::PostFilter) {
+                            driveInput = filtered;
+                            filtered = (FloatType) shaper.process(drive * filtered);
+                        }
+
+                        data[sample] = filtered * mix + in * (one - mix);
+                    }
+                }
+
+                channelState.envelope(channel) = envelope;
+                channelState.template storeFilterState<Filter::numStates>(channel, state);
+
+                if (drivePosition != DrivePosition::Off)
+                    channelState.driveInput(channel) = driveInput;
+            }
+
+            blockUntilTick = samplesUntilTickAfter(blockUntilTick, blockEnd - blockStart, interval);
+            blockStart = blockEnd;
+        }
+    }
+};
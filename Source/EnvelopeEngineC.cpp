@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    EnvelopeEngineC.cpp
+
+  ==============================================================================
+*/
+
+#include "EnvelopeEngineC.h"
+#include "EnvelopeEngine.h"
+
+#include <memory>
+#include <new>
+
+struct EnvelopeEngineHandle
+{
+    EnvelopeEngine<float> engine;
+};
+
+namespace
+{
+    template <typename Enum>
+    Enum toEnum(int value, Enum last) noexcept
+    {
+        return static_cast<Enum>(std::clamp(value, 0, static_cast<int>(last)));
+    }
+
+    EnvelopeParameters toEngineParameters(const EnvelopeEngineParameters& p) noexcept
+    {
+        EnvelopeParameters parameters;
+
+        parameters.gainFactor = p.gainFactor;
+        parameters.qFactor = p.qFactor;
+        parameters.dryWetMix = p.dryWetMix;
+        parameters.attackTime = p.attackTime;
+        parameters.releaseTime = p.releaseTime;
+        parameters.bandStart = p.bandStart;
+        parameters.bandWidth = p.bandWidth;
+        parameters.rmsWindow = p.rmsWindow;
+        parameters.drive = p.drive;
+
+        parameters.filterType = toEnum(p.filterType, FilterType::SvfNotch);
+        parameters.drivePosition = toEnum(p.drivePosition, DrivePosition::PostFilter);
+        parameters.detectorMode = toEnum(p.detectorMode, DetectorMode::TruePeak);
+
+        for (int source = 0; source < numModSources; ++source)
+            for (int destination = 0; destination < numModDestinations; ++destination)
+                parameters.modMatrix.amounts[source][destination] = p.modAmounts[source][destination];
+
+        return parameters;
+    }
+}
+
+void envelopeEngineGetDefaultParameters(EnvelopeEngineParameters* parameters)
+{
+    if (parameters == nullptr)
+        return;
+
+    const EnvelopeParameters defaults;
+
+    parameters->gainFactor = defaults.gainFactor;
+    parameters->qFactor = defaults.qFactor;
+    parameters->dryWetMix = defaults.dryWetMix;
+    parameters->attackTime = defaults.attackTime;
+    parameters->releaseTime = defaults.releaseTime;
+    parameters->bandStart = defaults.bandStart;
+    parameters->bandWidth = defaults.bandWidth;
+    parameters->rmsWindow = defaults.rmsWindow;
+    parameters->drive = defaults.drive;
+
+    parameters->filterType = static_cast<int>(defaults.filterType);
+    parameters->drivePosition = static_cast<int>(defaults.drivePosition);
+    parameters->detectorMode = static_cast<int>(defaults.detectorMode);
+
+    for (int source = 0; source < numModSources; ++source)
+        for (int destination = 0; destination < numModDestinations; ++destination)
+            parameters->modAmounts[source][destination] = defaults.modMatrix.amounts[source][destination];
+}
+
+EnvelopeEngineHandle* envelopeEngineCreate(double sampleRate, int numChannels, int controlInterval)
+{
+    if (!(sampleRate > 0.0) || numChannels <= 0 || controlInterval <= 0)
+        return nullptr;
+
+    try {
+        auto handle = std::make_unique<EnvelopeEngineHandle>();
+        handle->engine.prepare(sampleRate, numChannels, controlInterval);
+        return handle.release();
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void envelopeEngineDestroy(EnvelopeEngineHandle* engine)
+{
+    delete engine;
+}
+
+void envelopeEngineReset(EnvelopeEngineHandle* engine)
+{
+    if (engine != nullptr)
+        engine->engine.reset();
+}
+
+int envelopeEngineProcess(EnvelopeEngineHandle* engine, float* const* channels, int numSamples,
+                          const EnvelopeEngineParameters* parameters)
+{
+    if (engine == nullptr || channels == nullptr || parameters == nullptr || numSamples < 0)
+        return -1;
+
+    for (int channel = 0; channel < engine->engine.getNumChannels(); ++channel)
+        if (channels[channel] == nullptr)
+            return -1;
+
+    engine->engine.process(channels, numSamples, toEngineParameters(*parameters));
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    EnvelopeEngineC.h
+
+    C interface to the envelope engine, for batch processors that do not link
+    JUCE. One engine processes float audio in place at its own sample rate,
+    with control-rate coefficient updates, like the plugin in real time. The
+    LFO and velocity sources of the modulation matrix read as zero.
+
+    The EnvelopeEngine target of the CMake build is the static library,
+    it needs no more than a C++17 compiler and the standard library:
+
+        cmake -S . -B build && cmake --build build --target EnvelopeEngine
+
+    Link it with the C++ runtime (c++ as the linker, or -lstdc++).
+
+    Only create and destroy allocate or free memory. An engine may be used
+    from any thread, but from one thread at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct EnvelopeEngineHandle EnvelopeEngineHandle;
+
+enum
+{
+    envelopeFilterPeak,
+    envelopeFilterLadderBandPass,
+    envelopeFilterLadderLowPass,
+    envelopeFilterSvfBandPass,
+    envelopeFilterSvfNotch
+};
+
+enum
+{
+    envelopeDriveOff,
+    envelopeDrivePreFilter,
+    envelopeDrivePostFilter
+};
+
+enum
+{
+    envelopeDetectorPeak,
+    envelopeDetectorRms,
+    envelopeDetectorTruePeak
+};
+
+/** Same units as the plugin's parameters, except that drive is a linear
+    factor. modAmounts is indexed [source][destination], sources are
+    envelope, LFO and velocity, destinations cutoff, Q and gain.
+*/
+typedef struct EnvelopeEngineParameters
+{
+    float gainFactor, qFactor, dryWetMix;
+    float attackTime, releaseTime, bandStart, bandWidth;
+    float rmsWindow, drive;
+    int filterType, drivePosition, detectorMode;
+    float modAmounts[3][3];
+} EnvelopeEngineParameters;
+
+/** Fills parameters with the plugin's defaults. */
+void envelopeEngineGetDefaultParameters(EnvelopeEngineParameters* parameters);
+
+/** Returns NULL if an argument is not positive or memory runs out. A
+    controlInterval of 1 updates the coefficients every sample, the plugin
+    uses 32 in real time.
+*/
+EnvelopeEngineHandle* envelopeEngineCreate(double sampleRate, int numChannels, int controlInterval);
+
+void envelopeEngineDestroy(EnvelopeEngineHandle* engine);
+
+/** Clears the envelopes, detectors and filter state. */
+void envelopeEngineReset(EnvelopeEngineHandle* engine);
+
+/** Processes numSamples of every channel in place. channels holds one pointer
+    per channel the engine was created with. Returns 0 on success, -1 if an
+    argument is invalid.
+*/
+int envelopeEngineProcess(EnvelopeEngineHandle* engine, float* const* channels, int numSamples,
+                          const EnvelopeEngineParameters* parameters);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+
+    Branch-free approximations of exp, tan, sin, cos and tanh for the DSP path.
+
+    Every function is a plain inline template without lookup tables or data
+    dependent branches, so loops over them auto-vectorise. The approximations
+    are selected with the ENVELOPE_FAST_MATH preprocessor definition (add it to
+    the exporter's "Extra Preprocessor Definitions"):
+
+        ENVELOPE_FAST_MATH=0   exact <cmath> functions (default)
+        ENVELOPE_FAST_MATH=1   FastMath approximations for float
+
+    Only float computations use them. Their bounds are float-grade (exp is
+    about 1.6e-7 relative in double too), so DspMath keeps double, the offline
+    engine, on <cmath> either way.
+
+    Maximum errors in float, measured over the parameter ranges used by
+    createParameterLayout() at 44.1 - 192 kHz and asserted by the
+    fast-math-bounds test:
+
+        exp  relative error < 3e-7 for x in [-1, 1], < 4e-6 for x in [-87, 88]
+             attack/release coefficients: time constant within 0.04 % of std::exp's
+        sin  absolute error < 2.1e-7 for x in [-pi, pi]
+        cos  absolute error < 2.1e-7 for x in [-pi, pi]
+        tan  relative error < 5.4e-6 for x in [0, 0.49 * pi]
+        tanh relative error < 2e-7 for all x
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifndef ENVELOPE_FAST_MATH
+ #define ENVELOPE_FAST_MATH 0
+#endif
+
+namespace FastMath
+{
+    namespace detail
+    {
+        template <typename FloatType> struct Bits;
+
+        template <> struct Bits<float>
+        {
+            using Int = std::int32_t;
+            static constexpr int mantissaBits = 23, exponentBias = 127;
+            static constexpr float maxExp = 88.f, minExp = -87.f;
+        };
+
+        template <> struct Bits<double>
+        {
+            using Int = std::int64_t;
+            static constexpr int mantissaBits = 52, exponentBias = 1023;
+            static constexpr double maxExp = 709.0, minExp = -708.0;
+        };
+
+        // 2^n for an integral n inside the normal exponent range.
+        template <typename FloatType>
+        inline FloatType exp2Int(typename Bits<FloatType>::Int n) noexcept
+        {
+            using B = Bits<FloatType>;
+            auto bits = (n + B::exponentBias) << B::mantissaBits;
+
+            FloatType result;
+            std::memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        template <typename FloatType> constexpr FloatType pi = FloatType(3.14159265358979323846);
+        template <typename FloatType> constexpr FloatType halfPi = FloatType(1.57079632679489661923);
+        template <typename FloatType> constexpr FloatType twoPi = FloatType(6.28318530717958647692);
+        template <typename FloatType> constexpr FloatType log2e = FloatType(1.44269504088896340736);
+    }
+
+    /** e^x: split x * log2(e) into an integer and a fraction in [-0.5, 0.5],
+        evaluate 2^fraction with a degree 6 polynomial and scale by the exponent.
+    */
+    template <typename FloatType>
+    inline FloatType exp(FloatType x) noexcept
+    {
+        using namespace detail;
+        using B = Bits<FloatType>;
+
+        x = x < B::minExp ? FloatType(B::minExp) : (x > B::maxExp ? FloatType(B::maxExp) : x);
+
+        const auto t = x * log2e<FloatType>;
+        const auto n = std::floor(t + FloatType(0.5));
+        const auto f = t - n;
+
+        // Taylor coefficients of 2^f, ln(2)^k / k!
+        auto p = FloatType(1.5403530393381608e-4);
+        p = p * f + FloatType(1.3333558146428443e-3);
+        p = p * f + FloatType(9.6181291076284772e-3);
+        p = p * f + FloatType(5.5504108664821580e-2);
+        p = p * f + FloatType(2.4022650695910071e-1);
+        p = p * f + FloatType(6.9314718055994531e-1);
+        p = p * f + FloatType(1);
+
+        return p * exp2Int<FloatType>((typename B::Int) n);
+    }
+
+    /** sin(x) for x in [-pi, pi]: folds into [-pi/2, pi/2] and evaluates an odd
+        degree 11 polynomial.
+    */
+    template <typename FloatType>
+    inline FloatType sin(FloatType x) noexcept
+    {
+        using namespace detail;
+
+        const auto folded = std::copysign(pi<FloatType>, x) - x;
+        x = std::abs(x) > halfPi<FloatType> ? folded : x;
+
+        const auto x2 = x * x;
+
+        auto p = FloatType(-2.5052108385441720e-8);
+        p = p * x2 + FloatType(2.7557319223985893e-6);
+        p = p * x2 + FloatType(-1.9841269841269841e-4);
+        p = p * x2 + FloatType(8.3333333333333333e-3);
+        p = p * x2 + FloatType(-1.6666666666666667e-1);
+        p = p * x2 + FloatType(1);
+
+        return p * x;
+    }
+
+    /** cos(x) for x in [-pi, pi]. */
+    template <typename FloatType>
+    inline FloatType cos(FloatType x) noexcept
+    {
+        using namespace detail;
+
+        // Shift by a quarter turn and wrap back into [-pi, pi].
+        x += halfPi<FloatType>;
+        x = x > pi<FloatType> ? x - twoPi<FloatType> : x;
+
+        return sin(x);
+    }
+
+    /** tan(x) for x in [0, pi/2), as used by the bilinear prewarp
+        tan(pi * fc / fs). Accuracy degrades as x approaches pi/2.
+    */
+    template <typename FloatType>
+    inline FloatType tan(FloatType x) noexcept
+    {
+        return sin(x) / cos(x);
+    }
+
+    /** tanh(x): a [7/6] Pade approximant near zero, where (1 - e^-2|x|) would
+        cancel, and (1 - e^-2|x|) / (1 + e^-2|x|) everywhere else.
+    */
+    template <typename FloatType>
+    inline FloatType tanh(FloatType x) noexcept
+    {
+        const auto x2 = x * x;
+        const auto pade = x * (FloatType(135135) + x2 * (FloatType(17325) + x2 * (FloatType(378) + x2)))
+                        / (FloatType(135135) + x2 * (FloatType(62370) + x2 * (FloatType(3150) + FloatType(28) * x2)));
+
+        const auto t = exp(FloatType(-2) * std::abs(x));
+        const auto tail = std::copysign((FloatType(1) - t) / (FloatType(1) + t), x);
+
+        return std::abs(x) < FloatType(0.625) ? pade : tail;
+    }
+}
+
+/** The functions used by the DSP code, switched by ENVELOPE_FAST_MATH. */
+namespace DspMath
+{
+    // The approximations hold float-grade bounds, so only float uses them.
+    // Double, the offline engine, always gets <cmath>.
+    template <typename FloatType>
+    constexpr bool useFastMath = ENVELOPE_FAST_MATH && std::is_same_v<FloatType, float>;
+
+    template <typename FloatType> inline FloatType exp(FloatType x) noexcept
+    {
+        if constexpr (useFastMath<FloatType>) return FastMath::exp(x); else return std::exp(x);
+    }
+
+    template <typename FloatType> inline FloatType sin(FloatType x) noexcept
+    {
+        if constexpr (useFastMath<FloatType>) return FastMath::sin(x); else return std::sin(x);
+    }
+
+    template <typename FloatType> inline FloatType cos(FloatType x) noexcept
+    {
+        if constexpr (useFastMath<FloatType>) return FastMath::cos(x); else return std::cos(x);
+    }
+
+    template <typename FloatType> inline FloatType tan(FloatType x) noexcept
+    {
+        if constexpr (useFastMath<FloatType>) return FastMath::tan(x); else return std::tan(x);
+    }
+
+    template <typename FloatType> inline FloatType tanh(FloatType x) noexcept
+    {
+        if constexpr (useFastMath<FloatType>) return FastMath::tanh(x); else return std::tanh(x);
+    }
+}
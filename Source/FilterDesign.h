@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    FilterDesign.h
+
+    Biquad coefficient design for the envelope-controlled filter, built on the
+    DspMath functions so ENVELOPE_FAST_MATH switches it to the approximations.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FastMath.h"
+
+/** Biquad coefficients normalised so that a0 == 1. */
+template <typename FloatType>
+struct BiquadCoefficients
+{
+    FloatType b0{ 1 }, b1{ 0 }, b2{ 0 }, a1{ 0 }, a2{ 0 };
+};
+
+namespace FilterDesign
+{
+    /** Highest frequency handed to the designers, as a fraction of the sample rate. */
+    template <typename FloatType> constexpr FloatType maxFrequencyRatio = FloatType(0.49);
+
+    /** Keeps an envelope-driven frequency inside (0, maxFrequencyRatio * sampleRate). */
+    template <typename FloatType>
+    inline FloatType limitFrequency(FloatType frequency, FloatType sampleRate) noexcept
+    {
+        const auto upper = sampleRate * maxFrequencyRatio<FloatType>;
+        return frequency < FloatType(2) ? FloatType(2) : (frequency > upper ? upper : frequency);
+    }
+
+    /** One-pole smoothing coefficient exp(-1 / (timeSeconds * sampleRate)). */
+    template <typename FloatType>
+    inline FloatType makeTimeConstant(FloatType timeSeconds, FloatType sampleRate) noexcept
+    {
+        return DspMath::exp(FloatType(-1) / (timeSeconds * sampleRate));
+    }
+
+    /** Peak filter with a linear gain factor, same response as
+        juce::IIRCoefficients::makePeakFilter().
+    */
+    template <typename FloatType>
+    inline BiquadCoefficients<FloatType> makePeak(FloatType sampleRate, FloatType frequency,
+                                                  FloatType q, FloatType gainFactor) noexcept
+    {
+        const auto A = std::sqrt(gainFactor > FloatType(0) ? gainFactor : FloatType(0));
+        const auto omega = FloatType(6.28318530717958647692) * limitFrequency(frequency, sampleRate) / sampleRate;
+        const auto cosOmega = DspMath::cos(omega);
+        const auto alpha = FloatType(0.5) * DspMath::sin(omega) / q;
+        const auto alphaTimesA = alpha * A;
+        const auto alphaOverA = alpha / A;
+
+        const auto a0Inv = FloatType(1) / (FloatType(1) + alphaOverA);
+
+        BiquadCoefficients<FloatType> c;
+        c.b0 = (FloatType(1) + alphaTimesA) * a0Inv;
+        c.b1 = FloatType(-2) * cosOmega * a0Inv;
+        c.b2 = (FloatType(1) - alphaTimesA) * a0Inv;
+        c.a1 = c.b1;
+        c.a2 = (FloatType(1) - alphaOverA) * a0Inv;
+        return c;
+    }
+}
@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    FilterPolicies.h
+
+    The filter types the envelope sweeps, as compile-time policies.
+
+    A policy designs its coefficients from cutoff, Q and gain on a control
+    tick and filters one sample from coefficients and state held in locals.
+    The processor instantiates its channel loop once per policy, so every
+    type gets its own inlined inner loop and nothing is dispatched per sample.
+
+    Every policy keeps its coefficients and state in the same generic slots,
+    what a slot holds is up to the policy.
+
+    For the editor, a policy fills in |H|^2 at a set of frequencies. The
+    biquad and SVF policies write it as real functions of sin^2(w / 2), so
+    every point is the same few multiply-adds and the loop vectorises. Only
+    the ladder evaluates its small-signal response in complex arithmetic.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FilterDesign.h"
+
+#include <array>
+#include <complex>
+
+enum class FilterType
+{
+    Peak,
+    LadderBandPass,
+    LadderLowPass,
+    SvfBandPass,
+    SvfNotch
+};
+
+constexpr const char* filterTypeNames[] = { "Peak", "Ladder BP", "Ladder LP", "SVF BP", "SVF Notch" };
+
+namespace FilterPolicies
+{
+    constexpr int maxCoefficients = 6, maxStates = 5;
+
+    template <typename FloatType> using Coefficients = std::array<FloatType, maxCoefficients>;
+    template <typename FloatType> using State = std::array<FloatType, maxStates>;
+
+    /** Frequencies to evaluate a response at, as phi = sin^2(w / 2) and
+        z^-1 = e^-jw.
+    */
+    template <typename FloatType>
+    struct ResponsePoints
+    {
+        const FloatType* phi;
+        const std::complex<FloatType>* zInv;
+        int numPoints;
+    };
+
+    /** |H|^2 of (b0 + b1 z^-1 + b2 z^-2) / (a0 + a1 z^-1 + a2 z^-2) at every
+        point, as quadratics in phi. Unlike the expansion in cos(w) and cos(2w),
+        this does not cancel for poles close to z = 1, so low cutoffs stay
+        exact in float. The quadratics' coefficients are formed in double.
+    */
+    template <typename FloatType>
+    void biquadMagnitudesSquared(double b0, double b1, double b2, double a0, double a1, double a2,
+                                 const ResponsePoints<FloatType>& points, FloatType* magnitudes) noexcept
+    {
+        const auto num0 = (FloatType) ((b0 + b1 + b2) * (b0 + b1 + b2));
+        const auto num1 = (FloatType) (-4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2));
+        const auto num2 = (FloatType) (16.0 * b0 * b2);
+        const auto den0 = (FloatType) ((a0 + a1 + a2) * (a0 + a1 + a2));
+        const auto den1 = (FloatType) (-4.0 * (a0 * a1 + 4.0 * a0 * a2 + a1 * a2));
+        const auto den2 = (FloatType) (16.0 * a0 * a2);
+
+        for (int i = 0; i < points.numPoints; ++i)
+        {
+            const auto phi = points.phi[i];
+            magnitudes[i] = (num0 + phi * (num1 + phi * num2)) / (den0 + phi * (den1 + phi * den2));
+        }
+    }
+
+    /** Peak biquad in transposed direct form II. Gain is the boost at the cutoff. */
+    struct Peak
+    {
+        static constexpr int numStates = 2;
+
+        template <typename FloatType>
+        static Coefficients<FloatType> design(FloatType sampleRate, FloatType frequency, FloatType q, FloatType gain) noexcept
+        {
+            const auto c = FilterDesign::makePeak(sampleRate, frequency, q, gain);
+            return { c.b0, c.b1, c.b2, c.a1, c.a2, FloatType(0) };
+        }
+
+        template <typename FloatType>
+        static FloatType process(const Coefficients<FloatType>& c, State<FloatType>& s, FloatType x) noexcept
+        {
+            const auto y = c[0] * x + s[0];
+            s[0] = c[1] * x - c[3] * y + s[1];
+            s[1] = c[2] * x - c[4] * y;
+            return y;
+        }
+
+        /** Frequency response at z^-1 = zInv. */
+        template <typename FloatType>
+        static std::complex<FloatType> response(const Coefficients<FloatType>& c, std::complex<FloatType> zInv) noexcept
+        {
+            return (c[0] + zInv * (c[1] + zInv * c[2])) / (FloatType(1) + zInv * (c[3] + zInv * c[4]));
+        }
+
+        template <typename FloatType>
+        static void magnitudesSquared(const Coefficients<FloatType>& c, const ResponsePoints<FloatType>& points, FloatType* magnitudes) noexcept
+        {
+            biquadMagnitudesSquared((double) c[0], (double) c[1], (double) c[2], 1.0, (double) c[3], (double) c[4], points, magnitudes);
+        }
+    };
+
+    /** Four-pole transistor ladder with the topology of juce::dsp::LadderFilter,
+        in its 12 dB bandpass or 24 dB lowpass mode, but with the cutoff and
+        state of each channel kept apart. Q maps to the resonance and gain to
+        the input drive.
+    */
+    template <bool bandPass>
+    struct Ladder
+    {
+        static constexpr int numStates = 5;
+
+        template <typename FloatType>
+        static Coefficients<FloatType> design(FloatType sampleRate, FloatType frequency, FloatType q, FloatType gain) noexcept
+        {
+            const auto omega = FloatType(6.28318530717958647692) * FilterDesign::limitFrequency(frequency, sampleRate) / sampleRate;
+            const auto resonance = q / (FloatType(1) + q);
+            const auto drive = gain > FloatType(1) ? gain : FloatType(1);
+            const auto drive2 = drive * FloatType(0.04) + FloatType(0.96);
+
+            return { DspMath::exp(-omega),
+                     FloatType(-4) * (FloatType(0.1) + FloatType(0.9) * resonance),
+                     drive,
+                     std::pow(drive, FloatType(-2.642)) * FloatType(0.6103) + FloatType(0.3903),
+                     drive2,
+                     std::pow(drive2, FloatType(-2.642)) * FloatType(0.6103) + FloatType(0.3903) };
+        }
+
+        template <typename FloatType>
+        static FloatType process(const Coefficients<FloatType>& c, State<FloatType>& s, FloatType x) noexcept
+        {
+            const auto a1 = c[0];
+            const auto g = FloatType(1) - a1;
+            const auto b0 = g * FloatType(0.76923076923);
+            const auto b1 = g * FloatType(0.23076923076);
+
+            const auto dx = c[3] * DspMath::tanh(c[2] * x);
+            const auto a = dx + c[1] * (c[5] * DspMath::tanh(c[4] * s[4]) - dx * compensation<FloatType>);
+
+            const auto b = b1 * s[0] + a1 * s[1] + b0 * a;
+            const auto cc = b1 * s[1] + a1 * s[2] + b0 * b;
+            const auto d = b1 * s[2] + a1 * s[3] + b0 * cc;
+            const auto e = b1 * s[3] + a1 * s[4] + b0 * d;
+
+            s[0] = a;
+            s[1] = b;
+            s[2] = cc;
+            s[3] = d;
+            s[4] = e;
+
+            return bandPass ? d - cc : e;
+        }
+
+        /** Small-signal response, with both saturators taken as linear. */
+        template <typename FloatType>
+        static std::complex<FloatType> response(const Coefficients<FloatType>& c, std::complex<FloatType> zInv) noexcept
+        {
+            const auto a1 = c[0];
+            const auto g = FloatType(1) - a1;
+            const auto stage = (g * FloatType(0.76923076923) + zInv * (g * FloatType(0.23076923076))) / (FloatType(1) - zInv * a1);
+            const auto stage2 = stage * stage;
+
+            const auto input = c[3] * c[2] * (FloatType(1) - c[1] * compensation<FloatType>)
+                             / (FloatType(1) - c[1] * c[5] * c[4] * zInv * stage2 * stage2);
+
+            return bandPass ? input * (stage2 * stage - stage2) : input * stage2 * stage2;
+        }
+
+        /** The feedback around four poles is no biquad, so this one stays complex. */
+        template <typename FloatType>
+        static void magnitudesSquared(const Coefficients<FloatType>& c, const ResponsePoints<FloatType>& points, FloatType* magnitudes) noexcept
+        {
+            for (int i = 0; i < points.numPoints; ++i)
+                magnitudes[i] = std::norm(response(c, points.zInv[i]));
+        }
+
+    private:
+        template <typename FloatType> static constexpr FloatType compensation = FloatType(0.5);
+    };
+
+    /** Trapezoidal state-variable filter (Simper). The bandpass is normalised
+        to unity gain at the cutoff. Gain is not used.
+    */
+    template <bool notch>
+    struct Svf
+    {
+        static constexpr int numStates = 2;
+
+        template <typename FloatType>
+        static Coefficients<FloatType> design(FloatType sampleRate, FloatType frequency, FloatType q, FloatType) noexcept
+        {
+            const auto g = DspMath::tan(FloatType(3.14159265358979323846) * FilterDesign::limitFrequency(frequency, sampleRate) / sampleRate);
+            const auto k = FloatType(1) / q;
+            const auto a1 = FloatType(1) / (FloatType(1) + g * (g + k));
+            const auto a2 = g * a1;
+
+            return { a1, a2, g * a2, k, g, FloatType(0) };
+        }
+
+        template <typename FloatType>
+        static FloatType process(const Coefficients<FloatType>& c, State<FloatType>& s, FloatType x) noexcept
+        {
+            const auto v3 = x - s[1];
+            const auto v1 = c[0] * s[0] + c[1] * v3;
+            const auto v2 = s[1] + c[1] * s[0] + c[2] * v3;
+
+            s[0] = FloatType(2) * v1 - s[0];
+            s[1] = FloatType(2) * v2 - s[1];
+
+            return notch ? x - c[3] * v1 : c[3] * v1;
+        }
+
+        /** The analog prototype through the prewarped bilinear transform,
+            multiplied out so Nyquist does not divide by zero.
+        */
+        template <typename FloatType>
+        static std::complex<FloatType> response(const Coefficients<FloatType>& c, std::complex<FloatType> zInv) noexcept
+        {
+            const auto u = FloatType(1) - zInv;
+            const auto v = (FloatType(1) + zInv) * c[4];
+            const auto den = u * u + c[3] * u * v + v * v;
+
+            return notch ? (u * u + v * v) / den : c[3] * u * v / den;
+        }
+
+        /** |response()|^2 in closed form. With u = 1 - z^-1 and v = g (1 + z^-1)
+            on the unit circle, |u|^2 = 4 phi and |v|^2 = 4 g^2 (1 - phi), so
+            with r = g^2 (1 - phi) - phi and t = k^2 g^2 phi (1 - phi) the
+            notch is r^2 / (r^2 + t) and the bandpass t / (r^2 + t).
+        */
+        template <typename FloatType>
+        static void magnitudesSquared(const Coefficients<FloatType>& c, const ResponsePoints<FloatType>& points, FloatType* magnitudes) noexcept
+        {
+            const auto g2 = c[4] * c[4];
+            const auto k2g2 = c[3] * c[3] * g2;
+
+            for (int i = 0; i < points.numPoints; ++i)
+            {
+                const auto phi = points.phi[i];
+                const auto r = g2 * (FloatType(1) - phi) - phi;
+                const auto t = k2g2 * phi * (FloatType(1) - phi);
+                magnitudes[i] = (notch ? r * r : t) / (r * r + t);
+            }
+        }
+    };
+
+    using LadderBandPass = Ladder<true>;
+    using LadderLowPass = Ladder<false>;
+    using SvfBandPass = Svf<false>;
+    using SvfNotch = Svf<true>;
+}
+
+/** Calls callback with a default-constructed policy for a run-time filter type. */
+template <typename Callback>
+decltype(auto) withFilterPolicy(FilterType type, Callback&& callback)
+{
+    switch (type)
+    {
+        case FilterType::LadderBandPass: return callback(FilterPolicies::LadderBandPass{});
+        case FilterType::LadderLowPass:  return callback(FilterPolicies::LadderLowPass{});
+        case FilterType::SvfBandPass:    return callback(FilterPolicies::SvfBandPass{});
+        case FilterType::SvfNotch:       return callback(FilterPolicies::SvfNotch{});
+        case FilterType::Peak:
+        default:                         return callback(FilterPolicies::Peak{});
+    }
+}
@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+    LevelDetector.h
+
+    Per-channel level detectors that feed the attack/release envelope:
+
+        Peak       |x|
+        RMS        sqrt of the mean square over a selectable window, from
+                   prefix sums of the squares: O(1) per sample regardless
+                   of the window length, and O(1) to change the window
+        True Peak  max of |x| and a 4x polyphase interpolation of the input,
+                   catching inter-sample peaks of bright material
+
+    All buffers are allocated in prepare(); process() never allocates. Every
+    channel's indices and sums sit on a cache line of their own and every
+    channel's history starts on a fresh line, so channel groups processed on
+    different threads never write to the same line.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+enum class DetectorMode
+{
+    Peak,
+    Rms,
+    TruePeak
+};
+
+constexpr const char* detectorModeNames[] = { "Peak", "RMS", "True Peak" };
+
+template <typename FloatType>
+class LevelDetector
+{
+public:
+    static constexpr int truePeakFactor = 4;
+    static constexpr int truePeakTapsPerPhase = 12;
+    static constexpr int cacheLineBytes = 64;
+
+    /** Allocates the RMS windows and the true-peak history for numChannels. */
+    void prepare(double sampleRate, int numChannels, double maxRmsWindowSeconds)
+    {
+        fs = sampleRate;
+        channels = numChannels;
+        rmsCapacity = std::max(1, (int) std::ceil(maxRmsWindowSeconds * sampleRate)) + 1;
+
+        detectorState.assign((size_t) std::max(1, channels), DetectorState{});
+        rmsHistory = allocateRuns(rmsStorage, rmsCapacity, rmsStride);
+        truePeakHistory = allocateRuns(truePeakStorage, truePeakTapsPerPhase * 2, truePeakStride);
+
+        designTruePeakFilter();
+
+        rmsLength = std::min(rmsLength, rmsCapacity - 1);
+        reset();
+    }
+
+    void reset()
+    {
+        std::fill(rmsStorage.begin(), rmsStorage.end(), 0.0);
+        std::fill(truePeakStorage.begin(), truePeakStorage.end(), FloatType(0));
+        std::fill(detectorState.begin(), detectorState.end(), DetectorState{});
+    }
+
+    /** Changes the RMS window. The history holds prefix sums rather than
+        squares, so any window up to the capacity can be read straight off it
+        and a change of length costs nothing, whatever the mode and the number
+        of channels.
+    */
+    void setRmsWindow(double seconds) noexcept
+    {
+        rmsLength = std::clamp((int) std::lround(seconds * fs), 1, rmsCapacity - 1);
+    }
+
+    /** Detector level for the next input sample of a channel. */
+    template <DetectorMode mode>
+    FloatType process(int channel, FloatType in) noexcept
+    {
+        if constexpr (mode == DetectorMode::Rms)
+            return processRms(channel, in);
+        else if constexpr (mode == DetectorMode::TruePeak)
+            return processTruePeak(channel, in);
+        else
+            return std::abs(in);
+    }
+
+private:
+    // Everything a channel writes per sample besides its histories, one
+    // cache line per channel
+    struct alignas(cacheLineBytes) DetectorState
+    {
+        double rmsLapSum{ 0.0 }, rmsPreviousLapSum{ 0.0 };
+        int rmsWritePos{ 0 };
+        int truePeakWritePos{ 0 };
+    };
+
+    double fs{ 44100.0 };
+    int channels{ 0 };
+
+    std::vector<DetectorState> detectorState;
+
+    // Each slot holds the sum of the squares from the start of its lap of the
+    // ring up to and including its own sample. The window sum is the current
+    // sum minus the one rmsLength samples back, taken from the previous lap
+    // when the window reaches across the wrap. Restarting the sums every lap
+    // keeps them below rmsCapacity, so no precision is lost over time. One
+    // slot more than the longest window keeps the slot being written out of
+    // every window.
+    std::vector<double> rmsStorage;
+    double* rmsHistory = nullptr;
+    int rmsCapacity{ 1 }, rmsLength{ 1 }, rmsStride{ 0 };
+
+    // Each channel's history is stored twice in a row, so the taps of any
+    // phase can be read as one contiguous run without wrapping.
+    std::vector<FloatType> truePeakStorage;
+    FloatType* truePeakHistory = nullptr;
+    int truePeakStride{ 0 };
+    FloatType truePeakCoefficients[truePeakFactor][truePeakTapsPerPhase]{};
+
+    /** Sizes storage for one run of runLength values per channel, every run
+        starting on a cache line, and returns the first run.
+    */
+    template <typename ValueType>
+    ValueType* allocateRuns(std::vector<ValueType>& storage, int runLength, int& stride)
+    {
+        constexpr int lineValues = cacheLineBytes / (int) sizeof(ValueType);
+        stride = (runLength + lineValues - 1) / lineValues * lineValues;
+
+        storage.assign((size_t) (std::max(1, channels) * stride + lineValues), ValueType(0));
+
+        const auto misalignment = (int) (reinterpret_cast<std::uintptr_t>(storage.data()) % cacheLineBytes);
+        return storage.data() + (misalignment == 0 ? 0 : (cacheLineBytes - misalignment) / (int) sizeof(ValueType));
+    }
+
+    FloatType processRms(int channel, FloatType in) noexcept
+    {
+        auto* history = rmsHistory + channel * rmsStride;
+        auto& state = detectorState[(size_t) channel];
+        auto& pos = state.rmsWritePos;
+
+        state.rmsLapSum += (double) in * (double) in;
+        history[pos] = state.rmsLapSum;
+
+        const auto start = pos - rmsLength;
+        const auto before = start >= 0 ? history[start] : history[start + rmsCapacity] - state.rmsPreviousLapSum;
+        const auto sum = std::max(0.0, state.rmsLapSum - before);
+
+        if (++pos == rmsCapacity) {
+            pos = 0;
+            state.rmsPreviousLapSum = state.rmsLapSum;
+            state.rmsLapSum = 0.0;
+        }
+
+        return (FloatType) std::sqrt(sum / rmsLength);
+    }
+
+    FloatType processTruePeak(int channel, FloatType in) noexcept
+    {
+        auto* history = truePeakHistory + channel * truePeakStride;
+
+        auto& pos = detectorState[(size_t) channel].truePeakWritePos;
+        history[pos] = in;
+        history[pos + truePeakTapsPerPhase] = in;
+
+        // history[pos + 1 .. pos + taps] holds the input oldest first.
+        const auto* taps = history + pos + 1;
+        pos = pos + 1 == truePeakTapsPerPhase ? 0 : pos + 1;
+        auto peak = std::abs(in);
+
+        for (int phase = 0; phase < truePeakFactor; ++phase)
+        {
+            const auto* h = truePeakCoefficients[phase];
+            FloatType acc{ 0 };
+
+            for (int i = 0; i < truePeakTapsPerPhase; ++i)
+                acc += h[i] * taps[i];
+
+            peak = std::max(peak, std::abs(acc));
+        }
+
+        return peak;
+    }
+
+    // Blackman-windowed sinc interpolator at truePeakFactor times the sample
+    // rate, split into its polyphase components with unity DC gain each. Taps
+    // are stored time-reversed to match the oldest-first history.
+    void designTruePeakFilter()
+    {
+        constexpr int length = truePeakFactor * truePeakTapsPerPhase;
+        constexpr double pi = 3.14159265358979323846;
+        const double centre = (length - 1) * 0.5;
+
+        for (int phase = 0; phase < truePeakFactor; ++phase)
+        {
+            double sum = 0.0;
+
+            for (int i = 0; i < truePeakTapsPerPhase; ++i)
+            {
+                const auto n = i * truePeakFactor + phase;
+                const auto x = (n - centre) / truePeakFactor;
+                const auto sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+                const auto w = 0.42 - 0.5 * std::cos(2.0 * pi * n / (length - 1))
+                                    + 0.08 * std::cos(4.0 * pi * n / (length - 1));
+
+                truePeakCoefficients[phase][truePeakTapsPerPhase - 1 - i] = (FloatType) (sinc * w);
+                sum += sinc * w;
+            }
+
+            for (auto& h : truePeakCoefficients[phase])
+                h = (FloatType) (h / sum);
+        }
+    }
+};
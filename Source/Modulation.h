@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    Modulation.h
+
+    Tempo-synced LFO and the modulation matrix that routes the envelope, the
+    LFO and MIDI velocity to the filter cutoff, Q and gain.
+
+    Both are evaluated on the control-rate grid, once per control tick, never
+    per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FastMath.h"
+
+enum ModSource
+{
+    modEnvelope,
+    modLfo,
+    modVelocity,
+    numModSources
+};
+
+enum ModDestination
+{
+    modCutoff,
+    modQ,
+    modGain,
+    numModDestinations
+};
+
+/** Parameter IDs of the matrix amounts, indexed [source][destination]. */
+constexpr const char* modAmountIds[numModSources][numModDestinations] =
+{
+    { "Env > Cutoff",      "Env > Q",      "Env > Gain"      },
+    { "LFO > Cutoff",      "LFO > Q",      "LFO > Gain"      },
+    { "Velocity > Cutoff", "Velocity > Q", "Velocity > Gain" }
+};
+
+/** LFO rate choices, as shown to the user and as cycle lengths in quarter notes. */
+constexpr const char* lfoRateNames[] = { "4/1", "2/1", "1/1", "1/2", "1/4", "1/8", "1/16", "1/32",
+                                         "1/4T", "1/8T", "1/16T", "1/4.", "1/8." };
+constexpr float lfoRateBeats[] = { 16.f, 8.f, 4.f, 2.f, 1.f, 0.5f, 0.25f, 0.125f,
+                                   2.f / 3.f, 1.f / 3.f, 1.f / 6.f, 1.5f, 0.75f };
+
+struct ModMatrix
+{
+    float amounts[numModSources][numModDestinations]{};
+
+    /** Sum of every source scaled by its amount, per destination. */
+    void evaluate(const float (&sources)[numModSources], float (&destinations)[numModDestinations]) const noexcept
+    {
+        for (int d = 0; d < numModDestinations; ++d)
+        {
+            float sum = 0.f;
+
+            for (int s = 0; s < numModSources; ++s)
+                sum += amounts[s][d] * sources[s];
+
+            destinations[d] = sum;
+        }
+    }
+};
+
+/** Sine LFO whose cycle length is given in quarter notes. The phase follows
+    the host's PPQ position while it is playing and runs free otherwise.
+*/
+class TempoSyncedLfo
+{
+public:
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset() noexcept { phase = 0.0; }
+
+    void setRate(double beatsPerCycle, double bpm) noexcept
+    {
+        cycleBeats = beatsPerCycle;
+        phaseIncrement = bpm / (60.0 * sampleRate * beatsPerCycle);
+    }
+
+    /** Locks the phase to the host timeline at the start of a block. */
+    void syncToPpq(double ppqPosition) noexcept
+    {
+        const auto cycles = ppqPosition / cycleBeats;
+        phase = cycles - std::floor(cycles);
+    }
+
+    /** LFO value in [-1, 1] at a sample offset from the start of the block,
+        in host-rate samples. Oversampled callers pass fractional offsets.
+    */
+    float valueAt(double sampleOffset) const noexcept
+    {
+        auto p = phase + phaseIncrement * sampleOffset;
+        p -= std::floor(p);
+
+        // Map [0, 1) to [-pi, pi) for the DspMath sine.
+        return -DspMath::sin((float) ((p - 0.5) * 6.28318530717958647692));
+    }
+
+    /** Moves the phase on to the start of the next block. */
+    void advance(int numSamples) noexcept
+    {
+        phase += phaseIncrement * numSamples;
+        phase -= std::floor(phase);
+    }
+
+private:
+    double sampleRate{ 44100.0 }, phase{ 0.0 }, phaseIncrement{ 0.0 }, cycleBeats{ 1.0 };
+};
@@ -11,6 +11,45 @@
 
 //==============================================================================
 
+namespace
+{
+    // Label metadata for every rotary, in the order the editor declares them.
+    constexpr SliderSpec gainFactorSpec    { "Gain",           " ",  "1",     "Gain Factor",    "30"        };
+    constexpr SliderSpec qFactorSpec       { "Q",              " ",  "0.1",   "Q Factor",       "10"        };
+    constexpr SliderSpec filterTypeSpec    { "Filter Type",    "",   "Peak",  "Filter Type",    "SVF Notch" };
+    constexpr SliderSpec dryWetMixSpec     { "Dry/Wet Mix",    "%",  "0 %",   "Dry/Wet Mix",    "100 %"     };
+    constexpr SliderSpec attackTimeSpec    { "Attack Time",    "ms", "1 ms",  "Attack Time",    "50 ms"     };
+    constexpr SliderSpec releaseTimeSpec   { "Release Time",   "ms", "50 ms", "Release Time",   "500 ms"    };
+    constexpr SliderSpec bandStartSpec     { "Band Start",     "Hz", "50 Hz", "Band Start",     "2 kHz"     };
+    constexpr SliderSpec bandWidthSpec     { "Band Width",     "Hz", "50 Hz", "Band Width",     "10 kHz"    };
+    constexpr SliderSpec detectorSpec      { "Detector",       "",   "Peak",  "Detector",       "True Peak" };
+    constexpr SliderSpec rmsWindowSpec     { "RMS Window",     "ms", "5 ms",  "RMS Window",     "300 ms"    };
+    constexpr SliderSpec drivePositionSpec { "Drive Position", "",   "Off",   "Drive Position", "Post"      };
+    constexpr SliderSpec driveSpec         { "Drive",          "dB", "0 dB",  "Drive",          "24 dB"     };
+    constexpr SliderSpec lfoRateSpec       { "LFO Rate",       "",   "4/1",   "LFO Rate",       "1/8."      };
+
+    // The modulation matrix, a row per source and a column per destination
+    constexpr SliderSpec modAmountSpec(int source, int destination)
+    {
+        return { modAmountIds[source][destination], " ", "-1", modAmountIds[source][destination], "+1" };
+    }
+
+    constexpr SliderSpec modAmountSpecs[numModSources][numModDestinations] =
+    {
+        { modAmountSpec(0, 0), modAmountSpec(0, 1), modAmountSpec(0, 2) },
+        { modAmountSpec(1, 0), modAmountSpec(1, 1), modAmountSpec(1, 2) },
+        { modAmountSpec(2, 0), modAmountSpec(2, 1), modAmountSpec(2, 2) }
+    };
+}
+
+const juce::Font& LookAndFeel::getValueFont(float height)
+{
+    if (valueFont == nullptr || valueFont->getHeight() != height)
+        valueFont = std::make_unique<juce::Font>(height);
+
+    return *valueFont;
+}
+
 void LookAndFeel::drawRotarySlider(juce::Graphics& g,
     int x,
     int y,
@@ -55,7 +94,7 @@ void LookAndFeel::drawRotarySlider(juce::Graphics& g,
 
         g.fillPath(p);
 
-        g.setFont(rswl->getTextHeight());
+        g.setFont(getValueFont((float) rswl->getTextHeight()));
         auto text = rswl->getDisplayString();
         auto strWidth = g.getCurrentFont().getStringWidth(text);
 
@@ -128,15 +167,48 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
         endAng,
         *this);
 
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (labelCache.isNull() || labelCacheScale != scale)
+        renderLabelCache(scale);
+
+    g.drawImageTransformed(labelCache, AffineTransform::scale(1.f / scale));
+}
+
+void RotarySliderWithLabels::resized()
+{
+    juce::Slider::resized();
+
+    labelCache = {};
+}
+
+void RotarySliderWithLabels::renderLabelCache(float scale)
+{
+    using namespace juce;
+
+    labelCacheScale = scale;
+    labelCache = Image(Image::ARGB,
+        jmax(1, roundToInt(getWidth() * scale)),
+        jmax(1, roundToInt(getHeight() * scale)),
+        true);
+
+    Graphics g(labelCache);
+    g.addTransform(AffineTransform::scale(scale));
+
+    auto startAng = degreesToRadians(180.f + 55.f);
+    auto endAng = degreesToRadians(180.f - 55.f) + MathConstants<float>::twoPi;
+
+    auto sliderBounds = getSliderBounds();
     auto center = sliderBounds.toFloat().getCentre();
     auto radius = sliderBounds.getWidth() * 0.5f;
 
     g.setColour(Colour(255u, 126u, 13u));
 
-    auto numChoices = labels.size();
-    for (int i = 0; i < numChoices; ++i)
+    const LabelPos labels[] = { { 0.f, spec.minLabel }, { 1.22f, spec.title }, { 1.f, spec.maxLabel } };
+
+    for (const auto& label : labels)
     {
-        auto pos = labels[i].pos;
+        auto pos = label.pos;
         jassert(0.f <= pos);
         jassert(pos <= 1.22f);
 
@@ -145,9 +217,9 @@ void RotarySliderWithLabels::paint(juce::Graphics& g)
         auto c = center.getPointOnCircumference(radius + getTextHeight() * 0.5f + 1, ang);
 
         Rectangle<float> r;
-        auto str = labels[i].label;
+        String str(label.label);
 
-        if (labels[i].pos == 1.22f) {
+        if (pos == 1.22f) {
             g.setFont(getTextHeight() + 1);
             r.setSize(g.getCurrentFont().getStringWidthFloat(str), getTextHeight() - 6);
             r.setCentre(c);
@@ -190,38 +262,34 @@ juce::String RotarySliderWithLabels::getDisplayString() const
     juce::String str;
     bool addK = false;
 
-    auto numChoices = labels.size();
-    for (int i = 0; i < numChoices; ++i)
+    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
     {
-        if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
-        {
-            auto val = getValue();
-            float minValue = floatParam->range.start;
-            float maxValue = floatParam->range.end;
+        auto val = getValue();
+        float minValue = floatParam->range.start;
+        float maxValue = floatParam->range.end;
 
-            if (val > 999.f)
-            {
-                val /= 1000.f;
-                addK = true;
-            }
+        if (val > 999.f)
+        {
+            val /= 1000.f;
+            addK = true;
+        }
 
-            if (suffix == "%") {
-                float percentValue = round((val - minValue) / (maxValue - minValue) * 100.f);
-                str = juce::String(percentValue);
-            }
-            else if (suffix == "ms") {
-                float msValue = val * 1000.f;
-                str = juce::String(msValue);
-            }
-            else {
-                str = juce::String(val);
-            }     
+        if (suffix == "%") {
+            float percentValue = round((val - minValue) / (maxValue - minValue) * 100.f);
+            str = juce::String(percentValue);
         }
-        else
-        {
-            jassertfalse; //probably not necessery
+        else if (suffix == "ms") {
+            float msValue = val * 1000.f;
+            str = juce::String(msValue);
+        }
+        else {
+            str = juce::String(val);
         }
     }
+    else
+    {
+        jassertfalse; //probably not necessery
+    }
 
     if (suffix.isNotEmpty())
     {
@@ -340,21 +408,17 @@ void PowerButton::paint(juce::Graphics& g)
 
     g.setColour(Colour(255u, 126u, 13u));
 
-    auto numChoices = names.size();
-    for (int i = 0; i < numChoices; ++i)
-    {
-        auto c = center.getPointOnCircumference(radius + getTextHeight() * 0.5f + 1, degreesToRadians(180.f));
+    auto c = center.getPointOnCircumference(radius + getTextHeight() * 0.5f + 1, degreesToRadians(180.f));
 
-        Rectangle<float> r;
-        auto str = names[i].name;
+    Rectangle<float> r;
+    String str(name);
 
-        g.setFont(getTextHeight());
-        r.setSize(g.getCurrentFont().getStringWidthFloat(str), getTextHeight());
-        r.setCentre(c);
-        r.setY(r.getY() + getTextHeight() - 20);
+    g.setFont(getTextHeight());
+    r.setSize(g.getCurrentFont().getStringWidthFloat(str), getTextHeight());
+    r.setCentre(c);
+    r.setY(r.getY() + getTextHeight() - 20);
 
-        g.drawFittedText(str, r.toNearestInt(), juce::Justification::verticallyCentred, 1);
-    }
+    g.drawFittedText(str, r.toNearestInt(), juce::Justification::verticallyCentred, 1);
 }
 
 juce::Rectangle<int> PowerButton::getButtonBounds() const
@@ -372,68 +436,226 @@ juce::Rectangle<int> PowerButton::getButtonBounds() const
     return r;
 }
 
+ResponseCurveComponent::ResponseCurveComponent(EnvelopeAudioProcessor& p) : audioProcessor(p)
+{
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(framesPerSecond);
+}
+
+ResponseCurveComponent::~ResponseCurveComponent()
+{
+    stopTimer();
+}
+
+void ResponseCurveComponent::preparePoints(double sampleRate)
+{
+    pointsSampleRate = sampleRate;
+
+    const auto nyquist = (float) sampleRate * 0.5f;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto frequency = minFrequency * std::pow(maxFrequency / minFrequency, (float) i / (numPoints - 1));
+        auto omega = juce::MathConstants<float>::twoPi * juce::jmin(frequency, nyquist) / (float) sampleRate;
+
+        phi[(size_t) i] = juce::square(std::sin(0.5f * omega));
+        zInv[(size_t) i] = std::polar(1.f, -omega);
+    }
+}
+
+void ResponseCurveComponent::evaluateResponse(const FilterSnapshot::Values& values, FilterType type, bool bypassed)
+{
+    if (bypassed)
+    {
+        magnitudesDb.fill(0.f);
+        return;
+    }
+
+    // The same policy the processor runs, so the curve always matches the
+    // type. |H|^2 is filled in place, then converted to dB.
+    withFilterPolicy(type, [&](auto filter)
+        {
+            using Filter = decltype(filter);
+
+            const auto c = Filter::design((float) pointsSampleRate, values.cutoff, values.q, values.gain);
+            Filter::magnitudesSquared(c, { phi.data(), zInv.data(), numPoints }, magnitudesDb.data());
+        });
+
+    for (auto& magnitude : magnitudesDb)
+        magnitude = 10.f * std::log10(juce::jmax(magnitude, 1.0e-12f));
+}
+
+void ResponseCurveComponent::timerCallback()
+{
+    if (audioProcessor.spectrumAnalyzer.getPaths(inputSpectrum, outputSpectrum, spectrumVersion))
+        repaint();
+
+    const auto sampleRate = audioProcessor.getSampleRate();
+
+    if (sampleRate <= 0.0)
+        return;
+
+    bool force = false;
+
+    if (sampleRate != pointsSampleRate)
+    {
+        preparePoints(sampleRate);
+        force = true;
+    }
+
+    FilterSnapshot::Values values;
+    uint32_t version;
+
+    if (!audioProcessor.filterSnapshot.read(values, version))
+        return;
+
+    const auto bypassed = audioProcessor.apvts.getRawParameterValue("Bypass")->load() > 0.5f;
+    const auto type = static_cast<FilterType>(juce::roundToInt(audioProcessor.apvts.getRawParameterValue("Filter Type")->load()));
+
+    if (!force && hasResponse && version == lastVersion && bypassed == lastBypassed && type == lastType)
+        return;
+
+    lastVersion = version;
+    lastBypassed = bypassed;
+    lastType = type;
+    hasResponse = true;
+
+    evaluateResponse(values, type, bypassed);
+    updatePath();
+    repaint();
+}
+
+void ResponseCurveComponent::updatePath()
+{
+    responseCurve.clear();
+
+    if (!hasResponse)
+        return;
+
+    auto bounds = getLocalBounds().toFloat();
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto x = bounds.getX() + bounds.getWidth() * (float) i / (numPoints - 1);
+        auto y = juce::jmap(juce::jlimit(minDb, maxDb, magnitudesDb[(size_t) i]), minDb, maxDb, bounds.getBottom(), bounds.getY());
+
+        if (i == 0)
+            responseCurve.startNewSubPath(x, y);
+        else
+            responseCurve.lineTo(x, y);
+    }
+}
+
+void ResponseCurveComponent::renderBackground()
+{
+    using namespace juce;
+
+    background = Image(Image::RGB, jmax(1, getWidth()), jmax(1, getHeight()), true);
+    Graphics g(background);
+
+    auto bounds = getLocalBounds().toFloat();
+
+    g.fillAll(Colours::black);
+    g.setColour(Colours::dimgrey.withAlpha(0.5f));
+
+    for (auto frequency : { 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f })
+    {
+        auto x = bounds.getX() + bounds.getWidth() * std::log(frequency / minFrequency) / std::log(maxFrequency / minFrequency);
+        g.drawVerticalLine(roundToInt(x), bounds.getY(), bounds.getBottom());
+    }
+
+    for (auto db : { 0.f, 12.f, 24.f })
+    {
+        auto y = jmap(db, minDb, maxDb, bounds.getBottom(), bounds.getY());
+        g.drawHorizontalLine(roundToInt(y), bounds.getX(), bounds.getRight());
+    }
+
+    g.setColour(Colour(207u, 34u, 0u));
+    g.drawRect(bounds, 1.f);
+}
+
+void ResponseCurveComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+
+    if (background.isNull())
+        renderBackground();
+
+    g.drawImageAt(background, 0, 0);
+
+    // The spectra are normalised to a unit square by the analyzer
+    auto toBounds = AffineTransform::scale((float) getWidth(), (float) getHeight());
+
+    g.setColour(Colours::dimgrey.withAlpha(0.6f));
+    g.strokePath(inputSpectrum, PathStrokeType(1.f), toBounds);
+
+    g.setColour(Colour(207u, 34u, 0u).withAlpha(0.8f));
+    g.strokePath(outputSpectrum, PathStrokeType(1.f), toBounds);
+
+    g.setColour(Colour(255u, 126u, 13u));
+    g.strokePath(responseCurve, PathStrokeType(2.f));
+}
+
+void ResponseCurveComponent::resized()
+{
+    background = {};
+    updatePath();
+}
+
 //==============================================================================
 EnvelopeAudioProcessorEditor::EnvelopeAudioProcessorEditor (EnvelopeAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p),
-    gainFactorSlider(*audioProcessor.apvts.getParameter("Gain"), " "),
-    qFactorSlider(*audioProcessor.apvts.getParameter("Q"), " "),
-    dryWetMixSlider(*audioProcessor.apvts.getParameter("Dry/Wet Mix"), "%"),
-    attackTimeSlider(*audioProcessor.apvts.getParameter("Attack Time"), "ms"),
-    releaseTimeSlider(*audioProcessor.apvts.getParameter("Release Time"), "ms"),
-    bandStartSlider(*audioProcessor.apvts.getParameter("Band Start"), "Hz"),
-    bandWidthSlider(*audioProcessor.apvts.getParameter("Band Width"), "Hz"),
-
-    gainFactorSliderAttachment(audioProcessor.apvts, "Gain", gainFactorSlider),
-    qFactorSliderAttachment(audioProcessor.apvts, "Q", qFactorSlider),
-    dryWetMixSliderAttachment(audioProcessor.apvts, "Dry/Wet Mix", dryWetMixSlider),
-    attackTimeSliderAttachment(audioProcessor.apvts, "Attack Time", attackTimeSlider),
-    releaseTimeSliderAttachment(audioProcessor.apvts, "Release Time", releaseTimeSlider),
-    bandStartSliderAttachment(audioProcessor.apvts, "Band Start", bandStartSlider),
-    bandWidthSliderAttachment(audioProcessor.apvts, "Band Width", bandWidthSlider),
+    responseCurve(audioProcessor),
+    gainFactorSlider(audioProcessor.apvts, gainFactorSpec),
+    qFactorSlider(audioProcessor.apvts, qFactorSpec),
+    filterTypeSlider(audioProcessor.apvts, filterTypeSpec),
+    dryWetMixSlider(audioProcessor.apvts, dryWetMixSpec),
+    attackTimeSlider(audioProcessor.apvts, attackTimeSpec),
+    releaseTimeSlider(audioProcessor.apvts, releaseTimeSpec),
+    bandStartSlider(audioProcessor.apvts, bandStartSpec),
+    bandWidthSlider(audioProcessor.apvts, bandWidthSpec),
+    detectorSlider(audioProcessor.apvts, detectorSpec),
+    rmsWindowSlider(audioProcessor.apvts, rmsWindowSpec),
+    drivePositionSlider(audioProcessor.apvts, drivePositionSpec),
+    driveSlider(audioProcessor.apvts, driveSpec),
+    lfoRateSlider(audioProcessor.apvts, lfoRateSpec),
+
+    gainFactorSliderAttachment(audioProcessor.apvts, gainFactorSlider.getParamId(), gainFactorSlider),
+    qFactorSliderAttachment(audioProcessor.apvts, qFactorSlider.getParamId(), qFactorSlider),
+    filterTypeSliderAttachment(audioProcessor.apvts, filterTypeSlider.getParamId(), filterTypeSlider),
+    dryWetMixSliderAttachment(audioProcessor.apvts, dryWetMixSlider.getParamId(), dryWetMixSlider),
+    attackTimeSliderAttachment(audioProcessor.apvts, attackTimeSlider.getParamId(), attackTimeSlider),
+    releaseTimeSliderAttachment(audioProcessor.apvts, releaseTimeSlider.getParamId(), releaseTimeSlider),
+    bandStartSliderAttachment(audioProcessor.apvts, bandStartSlider.getParamId(), bandStartSlider),
+    bandWidthSliderAttachment(audioProcessor.apvts, bandWidthSlider.getParamId(), bandWidthSlider),
+    detectorSliderAttachment(audioProcessor.apvts, detectorSlider.getParamId(), detectorSlider),
+    rmsWindowSliderAttachment(audioProcessor.apvts, rmsWindowSlider.getParamId(), rmsWindowSlider),
+    drivePositionSliderAttachment(audioProcessor.apvts, drivePositionSlider.getParamId(), drivePositionSlider),
+    driveSliderAttachment(audioProcessor.apvts, driveSlider.getParamId(), driveSlider),
+    lfoRateSliderAttachment(audioProcessor.apvts, lfoRateSlider.getParamId(), lfoRateSlider),
 
     bypassButtonAttachment(audioProcessor.apvts, "Bypass", bypassButton)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
 
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
+    audioProcessor.spectrumAnalyzer.setEnabled(true);
+
+    for (const auto& row : modAmountSpecs) {
+        for (const auto& spec : row) {
+            auto* slider = modAmountSliders.add(new RotarySliderWithLabels(audioProcessor.apvts, spec));
+            modAmountSliderAttachments.add(new Attachment(audioProcessor.apvts, slider->getParamId(), *slider));
+        }
+    }
 
     for (auto* comp : getComps())
     {
         addAndMakeVisible(comp);
     }
 
-    gainFactorSlider.labels.add({ 0.f, "1" });
-    gainFactorSlider.labels.add({ 1.22f, "Gain Factor" });
-    gainFactorSlider.labels.add({ 1.f, "30" });
-
-    qFactorSlider.labels.add({ 0.f, "0.1" });
-    qFactorSlider.labels.add({ 1.22f, "Q Factor" });
-    qFactorSlider.labels.add({ 1.f, "10" });
+    bypassButton.name = "BYPASS";
 
-    dryWetMixSlider.labels.add({ 0.f, "0 %" });
-    dryWetMixSlider.labels.add({ 1.22f, "Dry/Wet Mix" });
-    dryWetMixSlider.labels.add({ 1.f, "100 %" });
-
-    attackTimeSlider.labels.add({ 0.f, "1 ms" });
-    attackTimeSlider.labels.add({ 1.22f, "Attack Time" });
-    attackTimeSlider.labels.add({ 1.f, "50 ms" });
-
-    releaseTimeSlider.labels.add({ 0.f, "50 ms" });
-    releaseTimeSlider.labels.add({ 1.22f, "Release Time" });
-    releaseTimeSlider.labels.add({ 1.f, "500 ms" });
-
-    bandStartSlider.labels.add({ 0.f, "50 Hz" });
-    bandStartSlider.labels.add({ 1.22f, "Band Start" });
-    bandStartSlider.labels.add({ 1.f, "2 kHz" });
-
-    bandWidthSlider.labels.add({ 0.f, "50 Hz" });
-    bandWidthSlider.labels.add({ 1.22f, "Band Width" });
-    bandWidthSlider.labels.add({ 1.f, "10 kHz" });
-
-    bypassButton.names.add({ "BYPASS" });
-
-    bypassButton.setLookAndFeel(&lnf);
+    bypassButton.setLookAndFeel(&lnf.get());
 
     auto safePtr = juce::Component::SafePointer<EnvelopeAudioProcessorEditor>(this);
 
@@ -442,22 +664,18 @@ EnvelopeAudioProcessorEditor::EnvelopeAudioProcessorEditor (EnvelopeAudioProcess
             if (auto* comp = safePtr.getComponent()) {
                 auto bypassed = comp->bypassButton.getToggleState();
 
-                comp->gainFactorSlider.setEnabled(!bypassed);
-                comp->qFactorSlider.setEnabled(!bypassed);
-                comp->dryWetMixSlider.setEnabled(!bypassed);
-                comp->attackTimeSlider.setEnabled(!bypassed);
-                comp->releaseTimeSlider.setEnabled(!bypassed);
-                comp->bandStartSlider.setEnabled(!bypassed);
-                comp->bandWidthSlider.setEnabled(!bypassed);
-
+                for (auto* slider : comp->getSliders())
+                    slider->setEnabled(!bypassed);
             }
         };
 
-    setSize (600, 400);
+    setSize (600, 830);
 }
 
 EnvelopeAudioProcessorEditor::~EnvelopeAudioProcessorEditor()
 {
+    audioProcessor.spectrumAnalyzer.setEnabled(false);
+
     bypassButton.setLookAndFeel(nullptr);
 }
 
@@ -479,9 +697,30 @@ void EnvelopeAudioProcessorEditor::resized()
     bounds.removeFromTop(20);
     bounds.removeFromBottom(20);
 
+    // LFO rate beside the modulation matrix, a row per source
+    auto modulationArea = bounds.removeFromBottom(300);
+    modulationArea.removeFromTop(10);
+
+    const auto rowHeight = modulationArea.getHeight() / numModSources;
+    auto lfoArea = modulationArea.removeFromLeft(modulationArea.getWidth() / 4);
+    lfoRateSlider.setBounds(lfoArea.withSizeKeepingCentre(lfoArea.getWidth(), rowHeight));
+
+    const auto columnWidth = modulationArea.getWidth() / numModDestinations;
+
+    for (int source = 0; source < numModSources; ++source) {
+        auto row = modulationArea.removeFromTop(rowHeight);
+
+        for (int destination = 0; destination < numModDestinations; ++destination)
+            modAmountSliders[source * numModDestinations + destination]->setBounds(row.removeFromLeft(columnWidth));
+    }
+
+    auto responseArea = bounds.removeFromTop(130);
+    responseCurve.setBounds(responseArea.removeFromTop(120).reduced(20, 0));
+
     auto filterArea = bounds.removeFromTop(bounds.getHeight() * 1.f / 3.f);
-    gainFactorSlider.setBounds(filterArea.removeFromLeft(filterArea.getWidth() * 1.f / 3.f));
-    qFactorSlider.setBounds(filterArea.removeFromLeft(filterArea.getWidth() * 0.5f));
+    gainFactorSlider.setBounds(filterArea.removeFromLeft(filterArea.getWidth() * 0.25f));
+    qFactorSlider.setBounds(filterArea.removeFromLeft(filterArea.getWidth() * 1.f / 3.f));
+    filterTypeSlider.setBounds(filterArea.removeFromLeft(filterArea.getWidth() * 0.5f));
     dryWetMixSlider.setBounds(filterArea);
 
     auto envelopeArea = bounds.removeFromTop(bounds.getHeight() * 0.5f);
@@ -491,21 +730,60 @@ void EnvelopeAudioProcessorEditor::resized()
     bandStartSlider.setBounds(envelopeArea.removeFromLeft(envelopeArea.getWidth() * 0.5f));
     bandWidthSlider.setBounds(envelopeArea);
 
+    auto bottomWidth = bounds.getWidth() * 0.2f;
+    detectorSlider.setBounds(bounds.removeFromLeft(bottomWidth));
+    rmsWindowSlider.setBounds(bounds.removeFromLeft(bottomWidth));
+    driveSlider.setBounds(bounds.removeFromRight(bottomWidth));
+    drivePositionSlider.setBounds(bounds.removeFromRight(bottomWidth));
     bypassButton.setBounds(bounds);
 }
 
 std::vector<juce::Component*> EnvelopeAudioProcessorEditor::getComps()
 {
-    return
+    std::vector<juce::Component*> comps
     {
+        &responseCurve,
+
         &gainFactorSlider,
         &qFactorSlider,
+        &filterTypeSlider,
         &dryWetMixSlider,
         &attackTimeSlider,
         &releaseTimeSlider,
         &bandStartSlider,
         &bandWidthSlider,
+        &detectorSlider,
+        &rmsWindowSlider,
+        &drivePositionSlider,
+        &driveSlider,
+        &lfoRateSlider,
 
         &bypassButton
     };
-}
\ No newline at end of file
+
+    comps.insert(comps.end(), modAmountSliders.begin(), modAmountSliders.end());
+    return comps;
+}
+
+std::vector<RotarySliderWithLabels*> EnvelopeAudioProcessorEditor::getSliders()
+{
+    std::vector<RotarySliderWithLabels*> sliders
+    {
+        &gainFactorSlider,
+        &qFactorSlider,
+        &filterTypeSlider,
+        &dryWetMixSlider,
+        &attackTimeSlider,
+        &releaseTimeSlider,
+        &bandStartSlider,
+        &bandWidthSlider,
+        &detectorSlider,
+        &rmsWindowSlider,
+        &drivePositionSlider,
+        &driveSlider,
+        &lfoRateSlider
+    };
+
+    sliders.insert(sliders.end(), modAmountSliders.begin(), modAmountSliders.end());
+    return sliders;
+}
\ No newline at end of file
@@ -28,17 +28,37 @@ struct LookAndFeel : juce::LookAndFeel_V4
         juce::ToggleButton& toggleButton,
         bool shouldDrawButtonAsHighlighted,
         bool shouldDrawButtonAsDown) override;
+
+    // Created on first use, shared by every knob through the shared LookAndFeel,
+    // which the processor keeps alive between editor opens.
+    const juce::Font& getValueFont(float height);
+
+private:
+    std::unique_ptr<juce::Font> valueFont;
+};
+
+// Static description of a rotary: the parameter it is attached to, the unit
+// suffix of its value readout and the three labels drawn around the knob.
+struct SliderSpec
+{
+    const char* paramId;
+    const char* suffix;
+    const char* minLabel;
+    const char* title;
+    const char* maxLabel;
 };
 
 struct RotarySliderWithLabels : juce::Slider
 {
-    RotarySliderWithLabels(juce::RangedAudioParameter& rap, const juce::String& unitSuffix) :
+    RotarySliderWithLabels(juce::AudioProcessorValueTreeState& apvts, const SliderSpec& sliderSpec) :
         juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,
             juce::Slider::TextEntryBoxPosition::NoTextBox),
-        param(&rap),
-        suffix(unitSuffix)
+        spec(sliderSpec),
+        param(apvts.getParameter(sliderSpec.paramId)),
+        suffix(sliderSpec.suffix)
     {
-        setLookAndFeel(&lnf);
+        jassert(param != nullptr);
+        setLookAndFeel(&lnf.get());
     }
 
     ~RotarySliderWithLabels()
@@ -49,42 +69,87 @@ struct RotarySliderWithLabels : juce::Slider
     struct LabelPos
     {
         float pos;
-        juce::String label;
+        const char* label;
     };
 
-    juce::Array<LabelPos> labels;
-
     void paint(juce::Graphics& g) override;
+    void resized() override;
     juce::Rectangle<int> getSliderBounds() const;
     int getTextHeight() const { return 14; }
     juce::String getDisplayString() const;
+    const char* getParamId() const { return spec.paramId; }
     void mouseDown(const juce::MouseEvent& event) override;
 
 private:
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<LookAndFeel> lnf;
 
+    const SliderSpec& spec;
     juce::RangedAudioParameter* param;
-    juce::RangedAudioParameter* name;
     juce::String suffix;
 
+    // The labels around the knob never change, so they are rendered once into
+    // an image on the first paint after a resize or scale change.
+    juce::Image labelCache;
+    float labelCacheScale{ 0.f };
+
+    void renderLabelCache(float scale);
     void showTextEditor();
     void updateSliderValue(juce::TextEditor* editor, juce::Slider* slider);
 };
 
 struct PowerButton : juce::ToggleButton
 {
-    struct ButtonName
-    {
-        juce::String name;
-    };
-
-    juce::Array<ButtonName> names;
+    const char* name{ "" };
 
     void paint(juce::Graphics& g) override;
     juce::Rectangle<int> getButtonBounds() const;
     int getTextHeight() const { return 14; }
 };
 
+// Magnitude response of the selected filter type (small-signal for the ladder)
+// at the first channel's current cutoff, Q and gain, over the input and output
+// spectrum of the first channel. The curve is re-evaluated at a throttled frame
+// rate and only when the processor has published new settings.
+struct ResponseCurveComponent : juce::Component, juce::Timer
+{
+    ResponseCurveComponent(EnvelopeAudioProcessor& p);
+    ~ResponseCurveComponent() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    void timerCallback() override;
+
+private:
+    static constexpr int numPoints = 256;
+    static constexpr int framesPerSecond = 30;
+    static constexpr float minFrequency = SpectrumAnalyzer::minFrequency, maxFrequency = SpectrumAnalyzer::maxFrequency;
+    static constexpr float minDb = -12.f, maxDb = 36.f;
+
+    EnvelopeAudioProcessor& audioProcessor;
+
+    // sin^2(w / 2) and z^-1 on the unit circle at every point, computed once
+    // per sample rate
+    double pointsSampleRate{ 0.0 };
+    std::array<float, numPoints> phi{};
+    std::array<std::complex<float>, numPoints> zInv{};
+    std::array<float, numPoints> magnitudesDb{};
+
+    uint32_t lastVersion{ 0 };
+    FilterType lastType{ FilterType::Peak };
+    bool lastBypassed{ false }, hasResponse{ false };
+
+    juce::Path responseCurve;
+    juce::Image background;
+
+    juce::Path inputSpectrum, outputSpectrum;
+    uint32_t spectrumVersion{ 0 };
+
+    void preparePoints(double sampleRate);
+    void evaluateResponse(const FilterSnapshot::Values& values, FilterType type, bool bypassed);
+    void updatePath();
+    void renderBackground();
+};
+
 //==============================================================================
 /**
 */
@@ -108,19 +173,29 @@ private:
     using Attachment = APVTS::SliderAttachment;
     using ButtonAttachment = APVTS::ButtonAttachment;
 
-    RotarySliderWithLabels gainFactorSlider, qFactorSlider, dryWetMixSlider,
-        attackTimeSlider, releaseTimeSlider, bandStartSlider, bandWidthSlider;
+    ResponseCurveComponent responseCurve;
+
+    RotarySliderWithLabels gainFactorSlider, qFactorSlider, filterTypeSlider, dryWetMixSlider,
+        attackTimeSlider, releaseTimeSlider, bandStartSlider, bandWidthSlider,
+        detectorSlider, rmsWindowSlider, drivePositionSlider, driveSlider, lfoRateSlider;
+
+    Attachment gainFactorSliderAttachment, qFactorSliderAttachment, filterTypeSliderAttachment, dryWetMixSliderAttachment,
+        attackTimeSliderAttachment, releaseTimeSliderAttachment, bandStartSliderAttachment, bandWidthSliderAttachment,
+        detectorSliderAttachment, rmsWindowSliderAttachment, drivePositionSliderAttachment, driveSliderAttachment,
+        lfoRateSliderAttachment;
 
-    Attachment gainFactorSliderAttachment, qFactorSliderAttachment, dryWetMixSliderAttachment,
-        attackTimeSliderAttachment, releaseTimeSliderAttachment, bandStartSliderAttachment, bandWidthSliderAttachment;
+    // One per modulation amount, source after source
+    juce::OwnedArray<RotarySliderWithLabels> modAmountSliders;
+    juce::OwnedArray<Attachment> modAmountSliderAttachments;
 
     PowerButton bypassButton;
 
     ButtonAttachment bypassButtonAttachment;
 
-    LookAndFeel lnf;
+    juce::SharedResourcePointer<LookAndFeel> lnf;
 
     std::vector<juce::Component*> getComps();
+    std::vector<RotarySliderWithLabels*> getSliders();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeAudioProcessorEditor)
 };
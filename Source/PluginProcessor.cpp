@@ -22,6 +22,9 @@ EnvelopeAudioProcessor::EnvelopeAudioProcessor()
                        )
 #endif
 {
+    // Whichever engine is running feeds the editor's response curve
+    realtimeEngine.setSnapshot(&filterSnapshot);
+    offlineEngine.setSnapshot(&filterSnapshot);
 }
 
 EnvelopeAudioProcessor::~EnvelopeAudioProcessor()
@@ -96,22 +99,92 @@ void EnvelopeAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
-    // Initialize peak filters
-    filters.clear();
-    for (int i = 0; i < getTotalNumInputChannels(); ++i) {
-        juce::IIRFilter* filter;
-        filters.add(filter = new juce::IIRFilter());
+    const auto numChannels = getTotalNumInputChannels();
+
+    // Initialize the real-time engine: envelopes, filters and level detectors
+    realtimeEngine.prepare(sampleRate, numChannels, realtimeControlInterval, 1, maxRmsWindowSeconds);
+
+    // Initialize the offline engine, oversampled up to maxOfflineSampleRate
+    int offlineOrder = 0;
+    while (offlineOrder < maxOfflineOversamplingOrder && sampleRate * (2 << offlineOrder) <= maxOfflineSampleRate)
+        ++offlineOrder;
+
+    offlineOversampling = std::make_unique<juce::dsp::Oversampling<double>>(
+        (size_t) juce::jmax(1, numChannels), (size_t) offlineOrder,
+        juce::dsp::Oversampling<double>::filterHalfBandFIREquiripple, true, true);
+    offlineOversampling->initProcessing((size_t) samplesPerBlock);
+    offlineBuffer.setSize(juce::jmax(1, numChannels), samplesPerBlock);
+    offlineEngine.prepare(sampleRate, numChannels, 1, 1 << offlineOrder, maxRmsWindowSeconds);
+    renderingOffline = false;
+
+    // The linear-phase half-bands delay the offline engine by a whole number
+    // of samples. Hosts set isNonRealtime() before preparing a bounce, so a
+    // prepare for one reports that delay and the host pre-rolls and trims it:
+    // the export lines up sample for sample with real-time playback, which
+    // stays at zero latency. The engine is chosen here, with the latency, so
+    // the two can never disagree.
+    useOfflineEngine = isNonRealtime();
+    setLatencySamples(useOfflineEngine ? juce::roundToInt(offlineOversampling->getLatencyInSamples()) : 0);
+
+    // Initialize modulation
+    lfo.prepare(sampleRate);
+
+    spectrumAnalyzer.prepare(sampleRate);
+
+   #if ENVELOPE_ENABLE_TRACE
+    // Every prepare starts a new trace file. When it cannot be created the
+    // engines trace nothing rather than fill a ring no thread drains.
+    auto* traceRing = traceRecorder.start(TraceRecorder::getDefaultFile(), sampleRate) ? &traceRecorder.getRing() : nullptr;
+    realtimeEngine.setTrace(traceRing, realtimeControlInterval);
+    offlineEngine.setTrace(traceRing, realtimeControlInterval);
+   #endif
+
+    // Initialize channel-group workers, only wide buses ever use them
+    const auto numWorkers = juce::jmin(juce::SystemStats::getNumCpus() - 1, 3,
+                                       (numChannels + channelGroupAlignment - 1) / channelGroupAlignment - 1);
+
+    if (numChannels >= minChannelsForGroups && numWorkers > 0) {
+        if (channelGroupPool == nullptr || channelGroupPool->getNumWorkers() != numWorkers)
+            channelGroupPool = std::make_unique<ChannelGroupPool>(numWorkers);
     }
+    else {
+        channelGroupPool.reset();
+    }
+
+    serialLoadEstimate = 0.0;
+    useChannelGroups = false;
 
-    // Initialize envelopes
-    for (int i = 0; i < getTotalNumInputChannels(); ++i)
-        envelopes.add(0.0f);
+    // Workers park when the host stops calling processBlock for a couple of blocks
+    if (channelGroupPool != nullptr) {
+        channelGroupPool->setIdleTimeout(workerIdleBlocks * samplesPerBlock / sampleRate);
+        channelGroupPool->setActive(false);
+    }
 }
 
 void EnvelopeAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    channelGroupPool.reset();
+    useChannelGroups = false;
+
+   #if ENVELOPE_ENABLE_TRACE
+    traceRecorder.stop();
+   #endif
+}
+
+void EnvelopeAudioProcessor::reset()
+{
+    // Clears every piece of running state, so a render after reset() depends
+    // only on the input and the parameters
+    realtimeEngine.reset();
+    offlineEngine.reset();
+
+    if (offlineOversampling != nullptr)
+        offlineOversampling->reset();
+
+    lfo.reset();
+    velocity = 0.f;
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -122,11 +195,11 @@ bool EnvelopeAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     return true;
   #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout from mono up to maxChannels is processed channel by channel,
+    // wide immersive buses included.
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -140,6 +213,143 @@ bool EnvelopeAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 }
 #endif
 
+void EnvelopeAudioProcessor::updateModulationSources(const ChainSettings& chainSettings, const juce::MidiBuffer& midiMessages)
+{
+    double bpm = 120.0;
+    juce::Optional<double> ppq;
+
+    if (auto* playHead = getPlayHead()) {
+        if (auto position = playHead->getPosition()) {
+            if (auto hostBpm = position->getBpm())
+                bpm = *hostBpm;
+
+            if (position->getIsPlaying())
+                ppq = position->getPpqPosition();
+        }
+    }
+
+    lfo.setRate(lfoRateBeats[chainSettings.lfoRate], bpm);
+
+    if (ppq.hasValue())
+        lfo.syncToPpq(*ppq);
+
+    // The last note-on of the block sets the velocity until the next one
+    for (const auto metadata : midiMessages) {
+        auto message = metadata.getMessage();
+
+        if (message.isNoteOn())
+            velocity = message.getFloatVelocity();
+    }
+}
+
+int EnvelopeAudioProcessor::getNumChannelGroups(int numChannels) const
+{
+    if (!useChannelGroups || channelGroupPool == nullptr || !channelGroupPool->isReady())
+        return 1;
+
+    const auto alignedGroups = (numChannels + channelGroupAlignment - 1) / channelGroupAlignment;
+    return juce::jmin(channelGroupPool->getNumWorkers() + 1, alignedGroups);
+}
+
+void EnvelopeAudioProcessor::updateChannelGroupMode(juce::int64 blockStartTicks, int numSamples, int numGroups)
+{
+    if (channelGroupPool == nullptr || numSamples == 0)
+        return;
+
+    // Fraction of the block's real-time budget spent processing, scaled back
+    // up to what a single thread would have needed
+    const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+    const auto load = elapsed * numGroups * getSampleRate() / numSamples;
+
+    serialLoadEstimate += 0.1 * (load - serialLoadEstimate);
+
+    if (!useChannelGroups && serialLoadEstimate > enableGroupsAboveLoad)
+        useChannelGroups = true;
+    else if (useChannelGroups && serialLoadEstimate < disableGroupsBelowLoad)
+        useChannelGroups = false;
+
+    channelGroupPool->setActive(useChannelGroups);
+}
+
+void EnvelopeAudioProcessor::processRealtime(juce::AudioBuffer<float>& buffer, int numChannels, const ChainSettings& chainSettings)
+{
+    const auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    const auto numSamples = buffer.getNumSamples();
+    auto* const* channelData = buffer.getArrayOfWritePointers();
+    const ModulationSources sources{ &lfo, velocity };
+
+    realtimeEngine.beginBlock(chainSettings);
+
+    const auto numGroups = getNumChannelGroups(numChannels);
+
+    if (numGroups > 1) {
+        const auto channelsPerGroup = ((numChannels + numGroups - 1) / numGroups + channelGroupAlignment - 1)
+                                      / channelGroupAlignment * channelGroupAlignment;
+
+        auto processGroup = [&](int group)
+            {
+                const auto firstChannel = group * channelsPerGroup;
+                const auto lastChannel = juce::jmin(numChannels, firstChannel + channelsPerGroup);
+
+                if (firstChannel < lastChannel)
+                    realtimeEngine.processChannels(channelData, numSamples, 0, firstChannel, lastChannel, chainSettings, sources);
+            };
+
+        channelGroupPool->run(numGroups, processGroup);
+    }
+    else {
+        realtimeEngine.processChannels(channelData, numSamples, 0, 0, numChannels, chainSettings, sources);
+    }
+
+    updateChannelGroupMode(blockStartTicks, numSamples, numGroups);
+
+    realtimeEngine.endBlock(numSamples);
+}
+
+void EnvelopeAudioProcessor::processOffline(juce::AudioBuffer<float>& buffer, int numChannels, const ChainSettings& chainSettings)
+{
+    const auto factor = offlineEngine.getOversamplingFactor();
+    const auto maxChunk = offlineBuffer.getNumSamples();
+    const ModulationSources sources{ &lfo, velocity };
+
+    offlineEngine.beginBlock(chainSettings);
+
+    // Hosts may render in blocks larger than announced, so work through the
+    // buffer in chunks the oversampler was prepared for
+    for (int start = 0; start < buffer.getNumSamples(); start += maxChunk) {
+        const auto numSamples = juce::jmin(maxChunk, buffer.getNumSamples() - start);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto* source = buffer.getReadPointer(channel, start);
+            auto* destination = offlineBuffer.getWritePointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (double) source[i];
+        }
+
+        juce::dsp::AudioBlock<double> block(offlineBuffer.getArrayOfWritePointers(), (size_t) numChannels, (size_t) numSamples);
+        auto upsampled = offlineOversampling->processSamplesUp(block);
+
+        double* channelData[maxChannels];
+        for (int channel = 0; channel < numChannels; ++channel)
+            channelData[channel] = upsampled.getChannelPointer((size_t) channel);
+
+        const auto numUpsampled = (int) upsampled.getNumSamples();
+        offlineEngine.processChannels(channelData, numUpsampled, start * factor, 0, numChannels, chainSettings, sources);
+        offlineEngine.endBlock(numUpsampled);
+
+        offlineOversampling->processSamplesDown(block);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const auto* source = offlineBuffer.getReadPointer(channel);
+            auto* destination = buffer.getWritePointer(channel, start);
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (float) source[i];
+        }
+    }
+}
+
 void EnvelopeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
@@ -148,60 +358,58 @@ void EnvelopeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
 
     auto chainSettings = getChainSettings(apvts);
 
-    auto gain = chainSettings.gainFactor;
-    auto q = chainSettings.qFactor;
-    auto mix = chainSettings.dryWetMix;
-    auto attack = chainSettings.attackTime;
-    auto release = chainSettings.releaseTime;
-    auto bs = chainSettings.bandStart;
-    auto bw = chainSettings.bandWidth;
     auto bypass = chainSettings.bypass;
 
+   #if ENVELOPE_ENABLE_TRACE
+    traceRecorder.getRing().beginBlock(buffer.getNumSamples(), isNonRealtime());
+   #endif
+
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
-    if (!bypass) {
-        for (int channel = 0; channel < totalNumInputChannels; ++channel) {
-            float* channelData = buffer.getWritePointer(channel);
-
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-
-                const float in = channelData[sample];
+    // The analyzer only costs a FIFO push, and nothing while no editor is open
+    const bool analyzing = spectrumAnalyzer.isEnabled() && totalNumInputChannels > 0;
 
-                // Envelope
-                float envelope;
-                aa = exp(-1.0f / (attack * getSampleRate()));
-                ar = exp(-1.0f / (release * getSampleRate()));
+    if (analyzing)
+        spectrumAnalyzer.pushInput(buffer.getReadPointer(0), buffer.getNumSamples());
 
-                // Level detector
-                if (fabs(in) > envelopes[channel]) {
-                    envelope = aa * envelopes[channel] + (1.0f - aa) * fabs(in);
-                }
-                else {
-                    envelope = ar * envelopes[channel] + (1.0f - ar) * fabs(in);
-                }
-
-                envelopes.set(channel, envelope);
-
-                // Update filter parameters depending on level
-                fc = bs + bw * envelopes[channel];
-
-                // Peak filter
-                for (int i = 0; i < filters.size(); ++i) {
-                    filters[i]->setCoefficients(juce::IIRCoefficients::makePeakFilter(getSampleRate(), fc, q, gain));
-                }
+    if (!bypass) {
+        updateModulationSources(chainSettings, midiMessages);
 
-                // Filtering
-                float filtered = filters[channel]->processSingleSampleRaw(in);
-                channelData[sample] = filtered * mix + channelData[sample] * (1.f - mix);
+        // Bounces and exports get the high-quality engine. The engine being
+        // switched to starts from a clean state rather than from whatever the
+        // last render left behind.
+        const auto offline = useOfflineEngine && offlineOversampling != nullptr;
 
+        if (offline != renderingOffline) {
+            renderingOffline = offline;
 
+            if (offline) {
+                offlineEngine.reset();
+                offlineOversampling->reset();
+            }
+            else {
+                realtimeEngine.reset();
             }
         }
+
+        if (offline)
+            processOffline(buffer, totalNumInputChannels, chainSettings);
+        else
+            processRealtime(buffer, totalNumInputChannels, chainSettings);
+
+        lfo.advance(buffer.getNumSamples());
     }
 
     for (int i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
+
+    if (analyzing)
+        spectrumAnalyzer.pushOutput(buffer.getReadPointer(0), buffer.getNumSamples());
+
+   #if ENVELOPE_ENABLE_TRACE
+    traceRecorder.getRing().endBlock();
+   #endif
 }
 
 //==============================================================================
@@ -212,6 +420,9 @@ bool EnvelopeAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* EnvelopeAudioProcessor::createEditor()
 {
+    if (editorLookAndFeel == nullptr)
+        editorLookAndFeel = std::make_unique<juce::SharedResourcePointer<LookAndFeel>>();
+
     return new EnvelopeAudioProcessorEditor(*this);
     //return new juce::GenericAudioProcessorEditor(*this);
 }
@@ -225,8 +436,10 @@ void EnvelopeAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 
 void EnvelopeAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    // Only accept state written by getStateInformation, anything else would
+    // replace the parameter tree with one the attachments can't find
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid())
+    if (tree.isValid() && tree.hasType(apvts.state.getType()))
     {
         apvts.replaceState(tree);
     }
@@ -243,6 +456,19 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
     settings.releaseTime = apvts.getRawParameterValue("Release Time")->load();
     settings.bandStart = apvts.getRawParameterValue("Band Start")->load();
     settings.bandWidth = apvts.getRawParameterValue("Band Width")->load();
+    settings.rmsWindow = apvts.getRawParameterValue("RMS Window")->load();
+
+    settings.drive = juce::Decibels::decibelsToGain(apvts.getRawParameterValue("Drive")->load());
+    settings.drivePosition = static_cast<DrivePosition>(juce::roundToInt(apvts.getRawParameterValue("Drive Position")->load()));
+
+    settings.filterType = static_cast<FilterType>(juce::roundToInt(apvts.getRawParameterValue("Filter Type")->load()));
+
+    settings.detectorMode = static_cast<DetectorMode>(juce::roundToInt(apvts.getRawParameterValue("Detector")->load()));
+    settings.lfoRate = juce::roundToInt(apvts.getRawParameterValue("LFO Rate")->load());
+
+    for (int source = 0; source < numModSources; ++source)
+        for (int destination = 0; destination < numModDestinations; ++destination)
+            settings.modMatrix.amounts[source][destination] = apvts.getRawParameterValue(modAmountIds[source][destination])->load();
 
     settings.bypass = apvts.getRawParameterValue("Bypass")->load() > 0.5f;
 
@@ -264,6 +490,28 @@ juce::AudioProcessorValueTreeState::ParameterLayout EnvelopeAudioProcessor::crea
 
     layout.add(std::make_unique<juce::AudioParameterBool>("Bypass", "Bypass", false));
 
+    // Hosts address automation by parameter index, so parameters added since
+    // the first release go after it, in the order they were added
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Detector", "Detector", juce::StringArray(detectorModeNames, juce::numElementsInArray(detectorModeNames)), 0));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("RMS Window", "RMS Window", juce::NormalisableRange<float>(0.005f, 0.300f, 0.001f, 1.f), 0.050f));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LFO Rate", "LFO Rate", juce::StringArray(lfoRateNames, juce::numElementsInArray(lfoRateNames)), 4));
+
+    for (int source = 0; source < numModSources; ++source) {
+        for (int destination = 0; destination < numModDestinations; ++destination) {
+            // The envelope sweeps the cutoff across the band by default
+            auto defaultAmount = (source == modEnvelope && destination == modCutoff) ? 1.f : 0.f;
+            auto id = modAmountIds[source][destination];
+
+            layout.add(std::make_unique<juce::AudioParameterFloat>(id, id, juce::NormalisableRange<float>(-1.f, 1.f, 0.01f, 1.f), defaultAmount));
+        }
+    }
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Drive", "Drive", juce::NormalisableRange<float>(0.f, 24.f, 0.1f, 1.f), 0.f));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Drive Position", "Drive Position", juce::StringArray(drivePositionNames, juce::numElementsInArray(drivePositionNames)), 0));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Type", "Filter Type", juce::StringArray(filterTypeNames, juce::numElementsInArray(filterTypeNames)), 0));
+
     return layout;
 }
 
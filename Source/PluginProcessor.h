@@ -9,6 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EnvelopeEngine.h"
+#include "ChannelGroupPool.h"
+#include "SpectrumAnalyzer.h"
+#if ENVELOPE_ENABLE_TRACE
+ #include "TraceRecorder.h"
+#endif
 //#include <cmath>
 //#include <math.h>
 //#define _USE_MATH_DEFINES
@@ -18,15 +24,17 @@
 /**
 */
 
-struct ChainSettings
+// The engine's parameters plus what only the plugin deals with
+struct ChainSettings : EnvelopeParameters
 {
-    float gainFactor{ 6.f }, qFactor{ 3.f }, dryWetMix{ 1.f },
-        attackTime{ 0.001f }, releaseTime{ 0.080f }, bandStart{ 250.f }, bandWidth{ 1000.f };
+    int lfoRate{ 4 };
     bool bypass{ false };
 };
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
+struct LookAndFeel;
+
 //==============================================================================
 /**
 */
@@ -43,6 +51,7 @@ public:
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    void reset() override;
 
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -73,17 +82,70 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    // Widest bus the processor accepts
+    static constexpr int maxChannels = 64;
+
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Parameters", createParameterLayout() };
 
+    FilterSnapshot filterSnapshot;
+    SpectrumAnalyzer spectrumAnalyzer;
+
 private:
 
-    float aa, ar, fc;
+    // The editors' LookAndFeel, held from the first open until the processor
+    // goes, so closing the editor does not throw away the fonts it has built
+    std::unique_ptr<juce::SharedResourcePointer<LookAndFeel>> editorLookAndFeel;
+
+    // Longest selectable RMS window, the detector buffers are sized for it
+    static constexpr double maxRmsWindowSeconds = 0.3;
+
+    // In real time, filter coefficients and modulation are updated every
+    // realtimeControlInterval samples, on a grid that carries on across host blocks
+    static constexpr int realtimeControlInterval = 32;
 
-    juce::Array<float> envelopes;
-    juce::OwnedArray<juce::IIRFilter> filters;
+    // Real time: float at the host rate with control-rate coefficients.
+    // Offline renders (isNonRealtime() when prepared): double, oversampled up
+    // to maxOfflineSampleRate with linear-phase half-bands, coefficients
+    // updated every sample, latency reported to the host. Both are prepared
+    // in prepareToPlay, switching between them never allocates.
+    static constexpr double maxOfflineSampleRate = 192000.0;
+    static constexpr int maxOfflineOversamplingOrder = 2;
+
+    EnvelopeEngine<float> realtimeEngine;
+    EnvelopeEngine<double> offlineEngine;
+    std::unique_ptr<juce::dsp::Oversampling<double>> offlineOversampling;
+    juce::AudioBuffer<double> offlineBuffer;
+    bool useOfflineEngine{ false }, renderingOffline{ false };
+
+    TempoSyncedLfo lfo;
+    float velocity{ 0.f };
+
+   #if ENVELOPE_ENABLE_TRACE
+    TraceRecorder traceRecorder;
+   #endif
 
-    juce::dsp::LadderFilter<float> bandPassFilter;
+    // Wide buses can be split into groups of channels processed on worker
+    // threads, real time only. Groups start on multiples of
+    // channelGroupAlignment channels, the runs ChannelStateBlock pads to their
+    // own cache lines, so no two groups share a line of channel state, and the
+    // mode switches on only when the measured cost of a block makes it
+    // worthwhile.
+    static constexpr int minChannelsForGroups = 16;
+    static constexpr int channelGroupAlignment = ChannelStateBlock<float>::runChannels;
+    static constexpr double enableGroupsAboveLoad = 0.5, disableGroupsBelowLoad = 0.25;
+    static constexpr int workerIdleBlocks = 2;
+
+    std::unique_ptr<ChannelGroupPool> channelGroupPool;
+    double serialLoadEstimate{ 0.0 };
+    bool useChannelGroups{ false };
+
+    int getNumChannelGroups(int numChannels) const;
+    void updateChannelGroupMode(juce::int64 blockStartTicks, int numSamples, int numGroups);
+
+    void processRealtime(juce::AudioBuffer<float>& buffer, int numChannels, const ChainSettings& chainSettings);
+    void processOffline(juce::AudioBuffer<float>& buffer, int numChannels, const ChainSettings& chainSettings);
+    void updateModulationSources(const ChainSettings& chainSettings, const juce::MidiBuffer& midiMessages);
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeAudioProcessor)
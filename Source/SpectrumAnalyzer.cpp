@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+//==============================================================================
+void SpectrumAnalyzer::SampleFifo::push(const float* data, int numSamples) noexcept
+{
+    const auto scope = fifo.write(numSamples);
+
+    if (scope.blockSize1 > 0)
+        std::copy(data, data + scope.blockSize1, buffer.begin() + scope.startIndex1);
+
+    if (scope.blockSize2 > 0)
+        std::copy(data + scope.blockSize1, data + scope.blockSize1 + scope.blockSize2, buffer.begin() + scope.startIndex2);
+}
+
+int SpectrumAnalyzer::SampleFifo::pull(float* destination, int numSamples) noexcept
+{
+    const auto scope = fifo.read(numSamples);
+
+    if (scope.blockSize1 > 0)
+        std::copy(buffer.begin() + scope.startIndex1, buffer.begin() + scope.startIndex1 + scope.blockSize1, destination);
+
+    if (scope.blockSize2 > 0)
+        std::copy(buffer.begin() + scope.startIndex2, buffer.begin() + scope.startIndex2 + scope.blockSize2, destination + scope.blockSize1);
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer() : juce::Thread("Envelope spectrum analyzer")
+{
+    input.smoothedDb.fill(minDb);
+    output.smoothedDb.fill(minDb);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    setEnabled(false);
+}
+
+void SpectrumAnalyzer::prepare(double sampleRate)
+{
+    currentSampleRate.store(sampleRate);
+}
+
+void SpectrumAnalyzer::setEnabled(bool shouldBeEnabled)
+{
+    if (shouldBeEnabled == isEnabled())
+        return;
+
+    if (shouldBeEnabled) {
+        enabled.store(true);
+        startThread(juce::Thread::Priority::low);
+    }
+    else {
+        enabled.store(false);
+        stopThread(500);
+    }
+}
+
+bool SpectrumAnalyzer::getPaths(juce::Path& inputPath, juce::Path& outputPath, uint32_t& version) const
+{
+    const juce::ScopedLock sl(pathLock);
+
+    if (publishedVersion == version)
+        return false;
+
+    inputPath = publishedInput;
+    outputPath = publishedOutput;
+    version = publishedVersion;
+    return true;
+}
+
+void SpectrumAnalyzer::run()
+{
+    // Samples left from the last time the analyzer was on, or pushed since
+    inputFifo.discard();
+    outputFifo.discard();
+
+    while (!threadShouldExit()) {
+        bool updated = false;
+
+        for (auto [fifo, channel] : { std::make_pair(&inputFifo, &input), std::make_pair(&outputFifo, &output) }) {
+            // Slide the window on by one hop for every hop of new samples
+            while (fifo->getNumReady() >= hopSize) {
+                std::copy(channel->timeData.begin() + hopSize, channel->timeData.end(), channel->timeData.begin());
+                fifo->pull(channel->timeData.data() + fftSize - hopSize, hopSize);
+
+                processFrame(*channel);
+                updated = true;
+            }
+        }
+
+        if (updated) {
+            buildPath(input);
+            buildPath(output);
+
+            const juce::ScopedLock sl(pathLock);
+            publishedInput.swapWithPath(input.path);
+            publishedOutput.swapWithPath(output.path);
+            ++publishedVersion;
+        }
+
+        wait(10);
+    }
+}
+
+void SpectrumAnalyzer::processFrame(Channel& channel)
+{
+    std::copy(channel.timeData.begin(), channel.timeData.end(), channel.fftData.begin());
+
+    window.multiplyWithWindowingTable(channel.fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(channel.fftData.data(), true);
+
+    // Hann window coherent gain is 0.5, scale so a full-scale sine reads 0 dB
+    const auto scale = 4.f / fftSize;
+
+    for (size_t bin = 0; bin < channel.smoothedDb.size(); ++bin) {
+        auto db = juce::Decibels::gainToDecibels(channel.fftData[bin] * scale, minDb);
+        channel.smoothedDb[bin] = smoothing * channel.smoothedDb[bin] + (1.f - smoothing) * db;
+    }
+}
+
+void SpectrumAnalyzer::buildPath(Channel& channel)
+{
+    const auto binsPerHz = fftSize / (float) currentSampleRate.load();
+    const auto lastBin = (float) (channel.smoothedDb.size() - 1);
+
+    channel.path.clear();
+    channel.path.preallocateSpace(numPathPoints * 3);
+
+    for (int i = 0; i < numPathPoints; ++i) {
+        const auto x = (float) i / (numPathPoints - 1);
+        const auto frequency = minFrequency * std::pow(maxFrequency / minFrequency, x);
+
+        // Linear interpolation between the two nearest bins
+        const auto bin = juce::jmin(frequency * binsPerHz, lastBin);
+        const auto index = (size_t) bin;
+        const auto next = juce::jmin(index + 1, channel.smoothedDb.size() - 1);
+        const auto frac = bin - (float) index;
+        const auto db = channel.smoothedDb[index] + frac * (channel.smoothedDb[next] - channel.smoothedDb[index]);
+
+        const auto y = juce::jlimit(0.f, 1.f, juce::jmap(db, maxDb, minDb, 0.f, 1.f));
+
+        if (i == 0)
+            channel.path.startNewSubPath(x, y);
+        else
+            channel.path.lineTo(x, y);
+    }
+}
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+    Input and output spectrum of the first channel, for the editor.
+
+    The audio thread only pushes samples into two wait-free single-producer
+    FIFOs, and only while an editor has switched the analyzer on. A background
+    thread runs overlapped, windowed FFTs, smooths them and turns them into
+    paths the editor scales to its bounds and draws. Only that thread touches
+    the read side of the FIFOs: it drops what was left in them when it starts,
+    the audio thread may still be pushing at that point.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <atomic>
+
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+    static constexpr float minFrequency = 20.f, maxFrequency = 20000.f;
+    static constexpr float minDb = -90.f, maxDb = 0.f;
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    void prepare(double sampleRate);
+
+    /** Starts or stops the background thread. Call from the message thread,
+        the editor switches the analyzer on while it is open.
+    */
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // Audio thread: wait-free, drops samples while a FIFO is full
+    void pushInput(const float* data, int numSamples) noexcept { inputFifo.push(data, numSamples); }
+    void pushOutput(const float* data, int numSamples) noexcept { outputFifo.push(data, numSamples); }
+
+    /** Copies the latest spectra if they are newer than version. The paths
+        span x in [0, 1] from minFrequency to maxFrequency on a log scale and
+        y in [0, 1] from maxDb down to minDb.
+    */
+    bool getPaths(juce::Path& input, juce::Path& output, uint32_t& version) const;
+
+private:
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numPathPoints = 256;
+    static constexpr float smoothing = 0.7f;
+
+    struct SampleFifo
+    {
+        static constexpr int capacity = 1 << 15;
+
+        void push(const float* data, int numSamples) noexcept;
+        int pull(float* destination, int numSamples) noexcept;
+        // Consumer side only: moves the read position up to the write
+        // position, so it is safe against a push in flight
+        void discard() noexcept { fifo.finishedRead(fifo.getNumReady()); }
+        int getNumReady() const noexcept { return fifo.getNumReady(); }
+
+        juce::AbstractFifo fifo{ capacity };
+        std::array<float, capacity> buffer{};
+    };
+
+    struct Channel
+    {
+        std::array<float, fftSize> timeData{};
+        std::array<float, fftSize * 2> fftData{};
+        std::array<float, fftSize / 2 + 1> smoothedDb{};
+        juce::Path path;
+    };
+
+    void run() override;
+    void processFrame(Channel& channel);
+    void buildPath(Channel& channel);
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<double> currentSampleRate{ 44100.0 };
+
+    SampleFifo inputFifo, outputFifo;
+    Channel input, output;
+
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann };
+
+    juce::CriticalSection pathLock;
+    juce::Path publishedInput, publishedOutput;
+    uint32_t publishedVersion{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    Trace.h
+
+    Opt-in trace of the first channel's control ticks, for looking into late
+    sweeps and dropouts after the fact. Built only with
+
+        ENVELOPE_ENABLE_TRACE=1
+
+    in the exporter's "Extra Preprocessor Definitions". Without it the engine
+    and the processor contain no trace code at all.
+
+    The audio thread stamps the first channel's control ticks into
+    TraceRecords, one per real-time control interval of host samples, and
+    pushes them into a wait-free single-producer, single-consumer ring,
+    dropping a record if the ring is full. The offline engine updates every
+    oversampled sample but is traced on the same grid, so a bounce running
+    far faster than real time does not outrun the ring either. TraceRecorder
+    drains the ring on a background thread into a file, Tools/TraceToCsv.cpp
+    converts the file to CSV.
+
+    File format, little-endian, no padding between fields:
+
+        TraceFileHeader, 32 bytes
+          0  char[8]  magic            "ENVTRACE"
+          8  uint32   version          1
+         12  uint32   recordSize       88
+         16  float64  sampleRate       host sample rate
+         24  uint64   numRecords       records that follow the header
+
+        TraceRecord, 88 bytes, one per traced control tick of channel 0
+          0  uint64   blockIndex       host block counter, from 0
+          8  uint64   blockStartNs     block start, ns since recording started
+         16  uint32   previousBlockNs  processing time of the previous block
+         20  uint32   blockSize        host samples in the block
+         24  uint32   tickOffset       engine samples from the block start
+         28  uint32   droppedRecords   records lost to a full ring before this one
+         32  float32  envelope         envelope value at the tick
+         36  float32  cutoff           modulated cutoff, Hz
+         40  float32  q                modulated Q
+         44  float32  gain             modulated gain
+         48  float32  gainFactor       parameters as set for the block
+         52  float32  qFactor
+         56  float32  bandStart
+         60  float32  bandWidth
+         64  float32  attackTime
+         68  float32  releaseTime
+         72  float32  dryWetMix
+         76  float32  drive
+         80  uint8    filterType       FilterType
+         81  uint8    detectorMode     DetectorMode
+         82  uint8    drivePosition    DrivePosition
+         83  uint8    offline          1 for the offline engine
+         84  uint32   reserved
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#ifndef ENVELOPE_ENABLE_TRACE
+ #define ENVELOPE_ENABLE_TRACE 0
+#endif
+
+struct TraceFileHeader
+{
+    static constexpr char expectedMagic[8] = { 'E', 'N', 'V', 'T', 'R', 'A', 'C', 'E' };
+    static constexpr uint32_t currentVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    double sampleRate;
+    uint64_t numRecords;
+};
+
+struct TraceRecord
+{
+    uint64_t blockIndex;
+    uint64_t blockStartNs;
+    uint32_t previousBlockNs;
+    uint32_t blockSize;
+    uint32_t tickOffset;
+    uint32_t droppedRecords;
+
+    float envelope, cutoff, q, gain;
+    float gainFactor, qFactor, bandStart, bandWidth, attackTime, releaseTime, dryWetMix, drive;
+
+    uint8_t filterType, detectorMode, drivePosition, offline;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(TraceFileHeader) == 32, "TraceFileHeader must match the documented layout");
+static_assert(sizeof(TraceRecord) == 88, "TraceRecord must match the documented layout");
+
+/** The audio thread's end of the trace: block bookkeeping plus the ring. */
+class TraceRing
+{
+public:
+    static constexpr uint32_t capacity = 1 << 13;
+
+    TraceRing() : records(capacity) {}
+
+    /** Restarts the clock and empties the ring. Not thread-safe, call it
+        while neither end is running.
+    */
+    void reset() noexcept
+    {
+        origin = Clock::now();
+        writeIndex.store(0, std::memory_order_relaxed);
+        readIndex.store(0, std::memory_order_relaxed);
+        block = {};
+        blockStart = origin;
+        nextBlockIndex = 0;
+        dropped = 0;
+    }
+
+    // Audio thread, around every host block
+    void beginBlock(int numSamples, bool offline) noexcept
+    {
+        blockStart = Clock::now();
+
+        block.blockIndex = nextBlockIndex++;
+        block.blockStartNs = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(blockStart - origin).count();
+        block.blockSize = (uint32_t) numSamples;
+        block.offline = offline ? 1 : 0;
+    }
+
+    void endBlock() noexcept
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - blockStart).count();
+        block.previousBlockNs = (uint32_t) (elapsed < (int64_t) UINT32_MAX ? elapsed : UINT32_MAX);
+    }
+
+    /** Audio thread: stamps the block fields into record and queues it.
+        Wait-free, drops the record if the ring is full.
+    */
+    void push(TraceRecord record) noexcept
+    {
+        const auto write = writeIndex.load(std::memory_order_relaxed);
+
+        if (write - readIndex.load(std::memory_order_acquire) >= capacity) {
+            ++dropped;
+            return;
+        }
+
+        record.blockIndex = block.blockIndex;
+        record.blockStartNs = block.blockStartNs;
+        record.previousBlockNs = block.previousBlockNs;
+        record.blockSize = block.blockSize;
+        record.offline = block.offline;
+        record.droppedRecords = dropped;
+        dropped = 0;
+
+        records[write % capacity] = record;
+        writeIndex.store(write + 1, std::memory_order_release);
+    }
+
+    /** Reader thread: moves up to maxRecords records to destination. */
+    int pop(TraceRecord* destination, int maxRecords) noexcept
+    {
+        const auto read = readIndex.load(std::memory_order_relaxed);
+        const auto available = writeIndex.load(std::memory_order_acquire) - read;
+        const auto count = available < (uint32_t) maxRecords ? available : (uint32_t) maxRecords;
+
+        for (uint32_t i = 0; i < count; ++i)
+            destination[i] = records[(read + i) % capacity];
+
+        readIndex.store(read + count, std::memory_order_release);
+        return (int) count;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<TraceRecord> records;
+    alignas(64) std::atomic<uint32_t> writeIndex{ 0 };
+    alignas(64) std::atomic<uint32_t> readIndex{ 0 };
+
+    // Audio thread only
+    alignas(64) TraceRecord block{};
+    Clock::time_point origin{ Clock::now() }, blockStart{ origin };
+    uint64_t nextBlockIndex{ 0 };
+    uint32_t dropped{ 0 };
+};
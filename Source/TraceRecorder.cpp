@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.cpp
+
+  ==============================================================================
+*/
+
+#include "TraceRecorder.h"
+
+TraceRecorder::TraceRecorder() : juce::Thread("Envelope trace recorder")
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+}
+
+juce::File TraceRecorder::getDefaultFile()
+{
+    const auto name = "Envelope-trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".envtrace";
+    return juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile(name).getNonexistentSibling();
+}
+
+bool TraceRecorder::start(const juce::File& traceFile, double sampleRate)
+{
+    stop();
+
+    file = traceFile;
+    fileSize = 0;
+    writePosition = (juce::int64) sizeof(TraceFileHeader);
+
+    if (!file.deleteFile() || !grow(writePosition))
+        return false;
+
+    auto* header = getHeader();
+    std::memcpy(header->magic, TraceFileHeader::expectedMagic, sizeof(header->magic));
+    header->version = TraceFileHeader::currentVersion;
+    header->recordSize = (uint32_t) sizeof(TraceRecord);
+    header->sampleRate = sampleRate;
+    header->numRecords = 0;
+
+    ring.reset();
+    recording = true;
+    startThread(juce::Thread::Priority::low);
+    return true;
+}
+
+void TraceRecorder::stop()
+{
+    if (!recording)
+        return;
+
+    recording = false;
+    stopThread(1000);
+    flush();
+
+    mapping.reset();
+
+    // Drop the unused tail of the last chunk
+    juce::FileOutputStream out(file);
+
+    if (out.openedOk() && out.setPosition(writePosition))
+        out.truncate();
+}
+
+void TraceRecorder::run()
+{
+    while (!threadShouldExit()) {
+        flush();
+        wait(flushIntervalMs);
+    }
+}
+
+void TraceRecorder::flush()
+{
+    for (;;) {
+        const auto count = ring.pop(scratch.data(), recordsPerPop);
+
+        if (count == 0)
+            return;
+
+        const auto bytes = (juce::int64) count * (juce::int64) sizeof(TraceRecord);
+
+        // Out of disk space: keep draining so the audio thread never sees a
+        // full ring, the trace ends at the last record that fit
+        if (mapping == nullptr || (writePosition + bytes > fileSize && !grow(writePosition + bytes)))
+            continue;
+
+        std::memcpy(static_cast<char*>(mapping->getData()) + writePosition, scratch.data(), (size_t) bytes);
+        writePosition += bytes;
+
+        getHeader()->numRecords += (uint64_t) count;
+    }
+}
+
+bool TraceRecorder::grow(juce::int64 minimumSize)
+{
+    const auto newSize = (minimumSize + chunkBytes - 1) / chunkBytes * chunkBytes;
+
+    // The mapping has to go before the file can be extended
+    mapping.reset();
+
+    {
+        juce::FileOutputStream out(file);
+
+        if (!out.openedOk() || !out.setPosition(newSize - 1) || !out.writeByte(0))
+            return false;
+    }
+
+    mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite);
+
+    if (mapping->getData() == nullptr || (juce::int64) mapping->getSize() < newSize) {
+        mapping.reset();
+        return false;
+    }
+
+    fileSize = newSize;
+    return true;
+}
+
+TraceFileHeader* TraceRecorder::getHeader() const noexcept
+{
+    return static_cast<TraceFileHeader*>(mapping->getData());
+}
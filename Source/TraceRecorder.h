@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+
+    Background writer of the trace described in Trace.h. Only compiled in with
+    ENVELOPE_ENABLE_TRACE=1.
+
+    A low-priority thread drains the ring every few milliseconds into a
+    memory-mapped file, growing the file a chunk at a time, and keeps the
+    record count in the header current so a trace survives a crash of the
+    host. stop() cuts the file down to the records written.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "Trace.h"
+
+class TraceRecorder : private juce::Thread
+{
+public:
+    TraceRecorder();
+    ~TraceRecorder() override;
+
+    /** Starts a new trace file, stopping the current one. Call it while the
+        audio thread is not pushing, from prepareToPlay.
+    */
+    bool start(const juce::File& traceFile, double sampleRate);
+    void stop();
+
+    TraceRing& getRing() noexcept { return ring; }
+
+    /** Envelope-trace-<date>-<time>.envtrace in the temporary directory. */
+    static juce::File getDefaultFile();
+
+private:
+    static constexpr juce::int64 chunkBytes = 4 << 20;
+    static constexpr int flushIntervalMs = 20;
+    static constexpr int recordsPerPop = 256;
+
+    void run() override;
+    void flush();
+    bool grow(juce::int64 minimumSize);
+    TraceFileHeader* getHeader() const noexcept;
+
+    TraceRing ring;
+
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    juce::int64 fileSize{ 0 }, writePosition{ 0 };
+    bool recording{ false };
+    std::array<TraceRecord, recordsPerPop> scratch{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TraceRecorder)
+};
@@ -0,0 +1,476 @@
+/*
+  ==============================================================================
+
+    EngineBenchmarks.cpp
+
+    Cost of the JUCE-free engine in ns per sample and channel, timed as the
+    fastest of several runs. Run a Release build on an otherwise idle machine.
+
+    ns-per-sample fails when a reference set costs more in the real-time
+    configuration than the --baseline file records for this machine, by more
+    than --threshold (see TestSupport.h). Without a baseline it only reports,
+    ctest passes the one set up by the CMake cache variables
+    ENVELOPE_BENCHMARK_BASELINE_DIR and ENVELOPE_BENCHMARK_THRESHOLD.
+
+  ==============================================================================
+*/
+
+#include "ReferenceRenders.h"
+#include "TestSupport.h"
+
+#include <memory>
+
+using namespace TestSupport;
+
+namespace
+{
+    constexpr int repeats = 7;
+
+    std::unique_ptr<Baseline> baseline;
+
+    // Keeps the compiler from dropping work whose result is never used
+    volatile float sink = 0.f;
+
+    /** ns per sample and channel of processing numSamples of input in host
+        blocks cycling through blockSizes, fresh engine state every run.
+        beforeBlock can change the parameters ahead of the block starting at a
+        given sample.
+    */
+    template <typename FloatType>
+    double measureEngine(EnvelopeParameters parameters, int numChannels, const std::vector<int>& blockSizes, int numSamples,
+                         int controlInterval = ReferenceRenders::controlInterval,
+                         const std::function<void(EnvelopeParameters&, int)>& beforeBlock = {})
+    {
+        std::vector<std::vector<FloatType>> input((size_t) numChannels), work((size_t) numChannels);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            for (int sample = 0; sample < numSamples; ++sample)
+                input[(size_t) channel].push_back((FloatType) ReferenceRenders::input(channel % ReferenceRenders::numChannels, sample));
+        }
+
+        EnvelopeEngine<FloatType> engine;
+        engine.prepare(ReferenceRenders::sampleRate, numChannels, controlInterval);
+
+        std::vector<FloatType*> channels((size_t) numChannels);
+
+        const auto ns = bestTimeNs(repeats, [&]
+            {
+                work = input;
+                engine.reset();
+
+                size_t nextSize = 0;
+
+                for (int start = 0; start < numSamples;) {
+                    const auto blockSize = std::min(blockSizes[nextSize++ % blockSizes.size()], numSamples - start);
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        channels[(size_t) channel] = work[(size_t) channel].data() + start;
+
+                    if (beforeBlock)
+                        beforeBlock(parameters, start);
+
+                    engine.process(channels.data(), blockSize, parameters);
+                    start += blockSize;
+                }
+            });
+
+        // Copying the input back in is part of every run, take it out again
+        const auto copyNs = bestTimeNs(repeats, [&] { work = input; });
+
+        return (ns - copyNs) / ((double) numSamples * numChannels);
+    }
+
+    /** Cost of each detector mode, on its own and in the engine with the
+        default peak filter, and of automating the RMS window every block.
+    */
+    bool detectorModes()
+    {
+        constexpr int numSamples = 48000;
+        const char* const modeNames[] = { "Peak", "RMS", "True Peak" };
+
+        std::printf("    detector alone, 2 channels\n");
+
+        for (int mode = 0; mode < 3; ++mode) {
+            LevelDetector<float> detector;
+            detector.prepare(ReferenceRenders::sampleRate, 2, 0.3);
+            detector.setRmsWindow(0.05);
+
+            std::vector<float> input;
+            for (int sample = 0; sample < numSamples; ++sample)
+                input.push_back(ReferenceRenders::input(0, sample));
+
+            auto sum = 0.f;
+
+            const auto ns = bestTimeNs(repeats, [&]
+                {
+                    detector.reset();
+
+                    for (int sample = 0; sample < numSamples; ++sample) {
+                        for (int channel = 0; channel < 2; ++channel) {
+                            switch (mode) {
+                                case 0: sum += detector.process<DetectorMode::Peak>(channel, input[(size_t) sample]); break;
+                                case 1: sum += detector.process<DetectorMode::Rms>(channel, input[(size_t) sample]); break;
+                                default: sum += detector.process<DetectorMode::TruePeak>(channel, input[(size_t) sample]); break;
+                            }
+                        }
+                    }
+                });
+
+            sink = sum;
+            std::printf("      %-10s %6.2f ns/sample\n", modeNames[mode], ns / (numSamples * 2.0));
+        }
+
+        for (const auto numChannels : { 2, 16 }) {
+            std::printf("    engine, %d channels\n", numChannels);
+
+            for (int mode = 0; mode < 3; ++mode) {
+                EnvelopeParameters parameters;
+                parameters.detectorMode = static_cast<DetectorMode>(mode);
+
+                std::printf("      %-10s %6.2f ns/sample\n", modeNames[mode],
+                            measureEngine<float>(parameters, numChannels, { ReferenceRenders::hostBlockSize }, numSamples));
+            }
+        }
+
+        // A window change only moves the read position, automating it every
+        // block must cost about as much as a fixed window
+        {
+            constexpr int blockSize = 32;
+
+            EnvelopeParameters parameters;
+            parameters.detectorMode = DetectorMode::Rms;
+
+            const auto fixed = measureEngine<float>(parameters, 2, { blockSize }, numSamples);
+            const auto automated = measureEngine<float>(parameters, 2, { blockSize }, numSamples, ReferenceRenders::controlInterval,
+                                                        [&](EnvelopeParameters& p, int start)
+                                                        { p.rmsWindow = 0.005f + 0.295f * (float) start / numSamples; });
+
+            std::printf("    RMS window, engine, 2 channels, %d sample blocks\n", blockSize);
+            std::printf("      fixed      %6.2f ns/sample\n", fixed);
+            std::printf("      automated  %6.2f ns/sample, 5 - 300 ms over the render\n", automated);
+        }
+
+        return true;
+    }
+
+    /** Cost of the reference sets in host block patterns real hosts send:
+        huge offline blocks, single samples, sizes that are not multiples of
+        the control interval and sizes that change every block.
+    */
+    bool blockSizes()
+    {
+        const std::vector<std::pair<const char*, std::vector<int>>> patterns = {
+            { "4096", { 4096 } },
+            { "512", { 512 } },
+            { "32", { 32 } },
+            { "7", { 7 } },
+            { "1", { 1 } },
+            { "31, 33", { 31, 33 } },
+            { "mixed", { 7, 33, 1, 100, 63 } },
+        };
+
+        std::printf("    %-36s", "ns/sample for host blocks of");
+        for (const auto& pattern : patterns)
+            std::printf(" %8.8s", pattern.first);
+        std::printf("\n");
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            std::printf("    %-36s", settings.name);
+
+            for (const auto& pattern : patterns)
+                std::printf(" %8.2f", measureEngine<float>(ReferenceRenders::toEngineParameters(settings), ReferenceRenders::numChannels,
+                                                           pattern.second, 48000));
+
+            std::printf("\n");
+        }
+
+        std::printf("    mixed: 7, 33, 1, 100, 63 samples over and over\n");
+        return true;
+    }
+
+    /** One 2x stage of a linear-phase half-band filter, Kaiser-windowed, in
+        polyphase form. Every other tap of a half-band is zero but the centre
+        one, so upsampling runs one branch of branchTaps taps and passes the
+        input through delayed for the other phase, and downsampling filters
+        the even phase and adds the odd one delayed. branchTaps is a multiple
+        of 8.
+    */
+    class HalfBand
+    {
+    public:
+        HalfBand(int branchTaps, double beta)
+            : branch((size_t) branchTaps), upHistory(branchTaps), evenHistory(branchTaps), oddHistory(branchTaps)
+        {
+            static constexpr double pi = 3.14159265358979323846;
+
+            const auto besselI0 = [](double x)
+                {
+                    double sum = 1.0, term = 1.0;
+                    for (int k = 1; k < 32; ++k) {
+                        term *= (0.5 * x / k) * (0.5 * x / k);
+                        sum += term;
+                    }
+                    return sum;
+                };
+
+            // Tap 2p of the causal filter, the odd offsets from the centre
+            double sum = 0.0;
+
+            for (int p = 0; p < branchTaps; ++p) {
+                const auto t = 2 * p - (branchTaps - 1);
+                const auto r = (double) t / branchTaps;
+                branch[(size_t) p] = std::sin(0.5 * pi * t) / (pi * t) * besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+                sum += branch[(size_t) p];
+            }
+
+            // Unity gain at DC with the centre tap of 0.5
+            for (auto& c : branch)
+                c *= 0.5 / sum;
+        }
+
+        /** One sample in, the next two at twice the rate out. */
+        void upsample(double x, double& y0, double& y1) noexcept
+        {
+            upHistory.push(x);
+            y0 = 2.0 * dot(upHistory.data());
+            y1 = upHistory.data()[branch.size() / 2 - 1];
+        }
+
+        /** Two samples in, one at half the rate out. */
+        double downsample(double x0, double x1) noexcept
+        {
+            evenHistory.push(x0);
+            oddHistory.push(x1);
+            return dot(evenHistory.data()) + 0.5 * oddHistory.data()[branch.size() / 2];
+        }
+
+    private:
+        // Written twice, a length apart, so every convolution reads one
+        // contiguous run, newest value first
+        struct History
+        {
+            explicit History(int length) : values((size_t) length * 2) {}
+
+            void push(double x) noexcept
+            {
+                const auto length = values.size() / 2;
+                pos = (pos == 0 ? length : pos) - 1;
+                values[pos] = values[pos + length] = x;
+            }
+
+            const double* data() const noexcept { return values.data() + pos; }
+
+            std::vector<double> values;
+            size_t pos{ 0 };
+        };
+
+        // The branch is symmetric, so taps are paired up, and summed into
+        // four accumulators so the additions do not wait on each other
+        double dot(const double* history) const noexcept
+        {
+            const auto length = branch.size();
+            double sums[4]{};
+
+            for (size_t p = 0; p < length / 2; p += 4)
+                for (size_t k = 0; k < 4; ++k)
+                    sums[k] += branch[p + k] * (history[p + k] + history[length - 1 - p - k]);
+
+            return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        }
+
+        std::vector<double> branch;
+        History upHistory, evenHistory, oddHistory;
+    };
+
+    /** tanh at 8x the rate between three polyphase half-band stages, the way
+        oversampling is usually built: what the drive stage would cost without
+        ADAA, and the reference its alias rejection is measured against. The
+        first stage passes up to 0.475 of the base rate and is about 100 dB
+        down from 0.525 of it, the later ones only need to reject the images
+        of that band and are far shorter.
+    */
+    class OversampledTanh
+    {
+    public:
+        static constexpr int factor = 8;
+
+        double process(double x) noexcept
+        {
+            double x2[2], x4[4], x8[8];
+
+            stages[0].upsample(x, x2[0], x2[1]);
+
+            for (int i = 0; i < 2; ++i)
+                stages[1].upsample(x2[i], x4[2 * i], x4[2 * i + 1]);
+
+            for (int i = 0; i < 4; ++i)
+                stages[2].upsample(x4[i], x8[2 * i], x8[2 * i + 1]);
+
+            for (auto& y : x8)
+                y = std::tanh(y);
+
+            for (int i = 0; i < 4; ++i)
+                x4[i] = stages[2].downsample(x8[2 * i], x8[2 * i + 1]);
+
+            for (int i = 0; i < 2; ++i)
+                x2[i] = stages[1].downsample(x4[2 * i], x4[2 * i + 1]);
+
+            return stages[0].downsample(x2[0], x2[1]);
+        }
+
+    private:
+        HalfBand stages[3]{ { 128, 10.0 }, { 16, 10.0 }, { 16, 10.0 } };
+    };
+
+    /** Power of the aliases relative to the harmonics below Nyquist, in dB,
+        for one exactly periodic window of a sine at bin k0 of length N.
+    */
+    double aliasToSignalDb(const std::vector<double>& window, int k0)
+    {
+        static constexpr double twoPi = 6.28318530717958647692;
+        const auto length = (int) window.size();
+
+        std::vector<double> cosTable((size_t) length), sinTable((size_t) length);
+        for (int n = 0; n < length; ++n) {
+            cosTable[(size_t) n] = std::cos(twoPi * n / length);
+            sinTable[(size_t) n] = std::sin(twoPi * n / length);
+        }
+
+        double signal = 0.0, aliases = 0.0;
+
+        for (int k = 1; k < length / 2; ++k) {
+            double re = 0.0, im = 0.0;
+
+            for (int n = 0, index = 0; n < length; ++n, index = (index + k) % length) {
+                re += window[(size_t) n] * cosTable[(size_t) index];
+                im -= window[(size_t) n] * sinTable[(size_t) index];
+            }
+
+            const auto power = re * re + im * im;
+            (k % k0 == 0 ? signal : aliases) += power;
+        }
+
+        return 10.0 * std::log10(aliases / signal);
+    }
+
+    /** Drive stage cost and alias rejection: plain tanh, the ADAA shaper
+        the engine uses and tanh at 8x between polyphase half-bands, on full
+        scale sines whose harmonics fold back below Nyquist.
+    */
+    bool adaa()
+    {
+        constexpr int windowLength = 4800, numSamples = 48000;
+        const double drivesDb[] = { 6.0, 12.0, 24.0 };
+        const int sineBins[] = { 501, 1001 };   // 5010 and 10010 Hz at 48 kHz
+
+        struct Shaper
+        {
+            const char* name;
+            std::function<std::function<double(double)>()> make;
+        };
+
+        const Shaper shapers[] = {
+            { "tanh", [] { return [](double x) { return std::tanh(x); }; } },
+            { "ADAA tanh", [] { return [shaper = Saturation::AdaaTanh{}](double x) mutable { return shaper.process(x); }; } },
+            { "tanh at 8x", [] { return [shaper = std::make_shared<OversampledTanh>()](double x) { return shaper->process(x); }; } },
+        };
+
+        std::printf("    %-12s %10s", "alias/signal", "ns/sample");
+        for (const auto bin : sineBins)
+            for (const auto driveDb : drivesDb)
+                std::printf("  %5.0f Hz %2.0f dB", bin * ReferenceRenders::sampleRate / windowLength, driveDb);
+        std::printf("\n");
+
+        // Cost over a second of the reference input at 12 dB of drive
+        std::vector<double> input;
+        for (int sample = 0; sample < numSamples; ++sample)
+            input.push_back(4.0 * ReferenceRenders::input(0, sample));
+
+        const auto timeShaper = [&](auto&& shape)
+            {
+                double sum = 0.0;
+                const auto ns = bestTimeNs(repeats, [&]
+                    {
+                        for (const auto x : input)
+                            sum += shape(x);
+                    });
+
+                sink = (float) sum;
+                return ns / numSamples;
+            };
+
+        Saturation::AdaaTanh adaaShaper;
+        OversampledTanh oversampledShaper;
+
+        const double costs[] = { timeShaper([](double x) { return std::tanh(x); }),
+                                 timeShaper([&](double x) { return adaaShaper.process(x); }),
+                                 timeShaper([&](double x) { return oversampledShaper.process(x); }) };
+
+        std::vector<double> ratios[3];
+
+        for (int s = 0; s < 3; ++s) {
+            std::printf("    %-12s %10.2f", shapers[s].name, costs[s]);
+
+            for (const auto bin : sineBins) {
+                for (const auto driveDb : drivesDb) {
+                    const auto gain = std::pow(10.0, driveDb / 20.0);
+                    auto shape = shapers[s].make();
+
+                    // Settle the filters, then take one period of the output
+                    std::vector<double> window((size_t) windowLength);
+
+                    for (int n = -2 * windowLength; n < windowLength; ++n) {
+                        const auto y = shape(gain * std::sin(6.28318530717958647692 * bin * n / windowLength));
+
+                        if (n >= 0)
+                            window[(size_t) n] = y;
+                    }
+
+                    ratios[s].push_back(aliasToSignalDb(window, bin));
+                    std::printf("  %10.1f dB", ratios[s].back());
+                }
+            }
+
+            std::printf("\n");
+        }
+
+        // ADAA must reject aliasing better than plain tanh wherever it folds
+        // back, and the 8x reference far better still
+        bool passed = true;
+
+        for (size_t i = 0; i < ratios[0].size(); ++i) {
+            passed &= expect(ratios[1][i] < ratios[0][i], "ADAA aliases more than plain tanh in column %d", (int) i + 1);
+            passed &= expect(ratios[2][i] < ratios[1][i], "tanh at 8x aliases more than ADAA in column %d", (int) i + 1);
+        }
+
+        return passed;
+    }
+
+    bool nsPerSample()
+    {
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            const auto ns = measureEngine<float>(ReferenceRenders::toEngineParameters(settings), ReferenceRenders::numChannels,
+                                                 { ReferenceRenders::hostBlockSize }, 48000);
+            std::printf("    %-36s %6.2f ns/sample\n", settings.name, ns);
+
+            passed &= baseline->check(settings.name, ns, "ns/sample");
+        }
+
+        return passed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const CommandLine commandLine(argc, argv);
+    baseline = std::make_unique<Baseline>(commandLine);
+
+    return runTests({
+        { "detector-modes", detectorModes },
+        { "block-sizes", blockSizes },
+        { "adaa", adaa },
+        { "ns-per-sample", nsPerSample },
+    }, commandLine);
+}
@@ -0,0 +1,322 @@
+/*
+  ==============================================================================
+
+    EngineTests.cpp
+
+    Tests of the JUCE-free DSP engine. --write-golden renders the reference
+    sets and replaces the files in Tests/Golden instead of checking them,
+    only do that for a change that is meant to alter the sound.
+
+  ==============================================================================
+*/
+
+#include "EnvelopeEngineC.h"
+#include "ReferenceRenders.h"
+#include "TestSupport.h"
+
+#include <thread>
+
+using namespace TestSupport;
+
+namespace
+{
+    const std::string goldenDirectory = ENVELOPE_GOLDEN_DIR;
+
+    // Rates the parameters are swept at, the offline engine runs at up to 192 kHz
+    constexpr double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+    /** Largest absolute and relative error of a float approximation against
+        the double <cmath> function, over every argument passed to add().
+    */
+    template <typename Approximation, typename Exact>
+    struct ErrorSweep
+    {
+        Approximation approximation;
+        Exact exact;
+        double absolute = 0.0, relative = 0.0;
+
+        void add(float x)
+        {
+            const auto expected = exact((double) x);
+            const auto error = std::abs((double) approximation(x) - expected);
+
+            absolute = std::max(absolute, error);
+            relative = std::max(relative, expected != 0.0 ? error / std::abs(expected) : error);
+        }
+
+        void addRange(double low, double high, int count = 1 << 20)
+        {
+            for (int i = 0; i <= count; ++i)
+                add((float) (low + (high - low) * i / count));
+        }
+    };
+
+    template <typename Approximation, typename Exact>
+    ErrorSweep<Approximation, Exact> makeSweep(Approximation approximation, Exact exact)
+    {
+        return { approximation, exact };
+    }
+
+    /** The FastMath bounds documented in FastMath.h, in float, over their
+        whole domains and over every argument the parameter ranges of
+        createParameterLayout() lead to, and DspMath keeping double exact.
+    */
+    bool fastMathBounds()
+    {
+        auto exp = makeSweep([](float x) { return FastMath::exp(x); }, [](double x) { return std::exp(x); });
+        auto expUnit = exp;
+        auto sin = makeSweep([](float x) { return FastMath::sin(x); }, [](double x) { return std::sin(x); });
+        auto cos = makeSweep([](float x) { return FastMath::cos(x); }, [](double x) { return std::cos(x); });
+        auto tan = makeSweep([](float x) { return FastMath::tan(x); }, [](double x) { return std::tan(x); });
+        auto tanh = makeSweep([](float x) { return FastMath::tanh(x); }, [](double x) { return std::tanh(x); });
+
+        static constexpr double pi = 3.14159265358979323846;
+
+        exp.addRange(-87.0, 88.0);
+        expUnit.addRange(-1.0, 1.0);
+        sin.addRange(-pi, pi);
+        cos.addRange(-pi, pi);
+        tan.addRange(0.0, 0.49 * pi);
+        tanh.addRange(-20.0, 20.0);
+
+        // Attack 1 - 50 ms and release 50 - 500 ms, on their 1 ms intervals
+        double timeConstantError = 0.0;
+
+        for (const auto sampleRate : sampleRates) {
+            for (int ms = 1; ms <= 500; ++ms) {
+                const auto time = (float) ms * 0.001f;
+                const auto x = -1.f / (time * (float) sampleRate);
+                exp.add(x);
+
+                // The time constants the coefficients imply. Rounding the
+                // coefficient to float costs up to 0.3 % at 500 ms and
+                // 192 kHz whatever computes it, so compare with std::exp in float.
+                const auto implied = -1.0 / (sampleRate * std::log((double) FastMath::exp(x)));
+                const auto expected = -1.0 / (sampleRate * std::log((double) std::exp(x)));
+                timeConstantError = std::max(timeConstantError, std::abs(implied - expected) / expected);
+            }
+
+            // Every cutoff the designers accept, band start 50 Hz up to the
+            // 0.49 * fs limit that modulation can push it to
+            for (int frequency = 2; frequency <= (int) (0.49 * sampleRate); ++frequency) {
+                const auto ratio = (float) frequency / (float) sampleRate;
+                sin.add(6.28318530717958647692f * ratio);
+                cos.add(6.28318530717958647692f * ratio);
+                tan.add(3.14159265358979323846f * ratio);
+            }
+        }
+
+        // Double, the offline engine, is left to <cmath> whatever the build
+        bool doubleExact = true;
+
+        for (double x = -4.0; x <= 4.0; x += 0.001)
+            doubleExact &= DspMath::exp(x) == std::exp(x) && DspMath::sin(x) == std::sin(x) && DspMath::cos(x) == std::cos(x)
+                        && DspMath::tan(x) == std::tan(x) && DspMath::tanh(x) == std::tanh(x);
+
+        std::printf("    exp  %.3g relative, %.3g on [-1, 1]\n", exp.relative, expUnit.relative);
+        std::printf("    sin  %.3g absolute\n", sin.absolute);
+        std::printf("    cos  %.3g absolute\n", cos.absolute);
+        std::printf("    tan  %.3g relative\n", tan.relative);
+        std::printf("    tanh %.3g relative\n", tanh.relative);
+        std::printf("    time constants %.3g relative\n", timeConstantError);
+
+        bool passed = true;
+        passed &= expect(exp.relative < 4e-6, "exp relative error %g", exp.relative);
+        passed &= expect(expUnit.relative < 3e-7, "exp relative error on [-1, 1] %g", expUnit.relative);
+        passed &= expect(sin.absolute < 2.1e-7, "sin absolute error %g", sin.absolute);
+        passed &= expect(cos.absolute < 2.1e-7, "cos absolute error %g", cos.absolute);
+        passed &= expect(tan.relative < 5.4e-6, "tan relative error %g", tan.relative);
+        passed &= expect(tanh.relative < 2.0e-7, "tanh relative error %g", tanh.relative);
+        passed &= expect(timeConstantError < 4e-4, "time constant error %g", timeConstantError);
+        passed &= expect(doubleExact, "DspMath approximates in double");
+        return passed;
+    }
+
+    bool goldenRenders()
+    {
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            std::vector<float> golden;
+
+            if (!expect(ReferenceRenders::readGolden(ReferenceRenders::goldenPath(goldenDirectory, settings), golden),
+                        "%s: no golden render, run EnvelopeTests --write-golden", settings.name)) {
+                passed = false;
+                continue;
+            }
+
+            const auto difference = ReferenceRenders::maxDifference(ReferenceRenders::renderWithEngine(settings), golden);
+            std::printf("    %-36s max difference %.3g\n", settings.name, difference);
+
+            passed &= expect(difference <= ReferenceRenders::tolerance, "%s: differs from the golden render by %g",
+                             settings.name, difference);
+        }
+
+        return passed;
+    }
+
+    /** Host block sizes must not change the output: the control grid and
+        the micro-blocks carry on across host blocks.
+    */
+    bool blockSizeInvariance()
+    {
+        const std::vector<std::vector<int>> patterns = { { 4096 }, { 1 }, { 7, 33, 1, 100, 63 }, { 31, 33 } };
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            const auto reference = ReferenceRenders::renderWithEngine(settings);
+            auto largest = 0.f;
+
+            for (const auto& pattern : patterns)
+                largest = std::max(largest, ReferenceRenders::maxDifference(ReferenceRenders::renderWithEngine(settings, pattern), reference));
+
+            std::printf("    %-36s max difference %.3g\n", settings.name, largest);
+            passed &= expect(largest == 0.f, "%s: output depends on the host block size", settings.name);
+        }
+
+        return passed;
+    }
+
+    /** A wide bus split into channel groups of ChannelStateBlock's run
+        length, each group on a thread of its own, renders bit for bit what
+        one thread does.
+    */
+    bool channelGroups()
+    {
+        constexpr int busChannels = 18;
+        constexpr int channelsPerGroup = ChannelStateBlock<float>::runChannels;
+
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            const auto serial = ReferenceRenders::renderChannelGroups(settings, busChannels, busChannels,
+                [](int, auto& processGroup) { processGroup(0); });
+
+            const auto grouped = ReferenceRenders::renderChannelGroups(settings, busChannels, channelsPerGroup,
+                [](int numGroups, auto& processGroup)
+                {
+                    std::vector<std::thread> threads;
+
+                    for (int group = 1; group < numGroups; ++group)
+                        threads.emplace_back([&processGroup, group] { processGroup(group); });
+
+                    processGroup(0);
+
+                    for (auto& thread : threads)
+                        thread.join();
+                });
+
+            const auto difference = ReferenceRenders::maxDifference(grouped, serial);
+            std::printf("    %-36s max difference %.3g\n", settings.name, difference);
+            passed &= expect(difference == 0.f, "%s: groups of %d channels differ from the serial render",
+                             settings.name, channelsPerGroup);
+        }
+
+        return passed;
+    }
+
+    /** The static library renders the goldens through the C interface too.
+        It has no LFO, the sets that use one are skipped.
+    */
+    bool cApi()
+    {
+        using namespace ReferenceRenders;
+
+        bool passed = true;
+
+        passed &= expect(envelopeEngineCreate(0.0, 2, 32) == nullptr, "created an engine at 0 Hz");
+        passed &= expect(envelopeEngineCreate(sampleRate, 0, 32) == nullptr, "created an engine without channels");
+        passed &= expect(envelopeEngineCreate(sampleRate, 2, 0) == nullptr, "created an engine without a control interval");
+
+        for (const auto& settings : getSettings()) {
+            if (settings.usesLfo())
+                continue;
+
+            EnvelopeEngineParameters parameters;
+            envelopeEngineGetDefaultParameters(&parameters);
+
+            const auto p = toEngineParameters(settings);
+            parameters.gainFactor = p.gainFactor;
+            parameters.qFactor = p.qFactor;
+            parameters.dryWetMix = p.dryWetMix;
+            parameters.attackTime = p.attackTime;
+            parameters.releaseTime = p.releaseTime;
+            parameters.bandStart = p.bandStart;
+            parameters.bandWidth = p.bandWidth;
+            parameters.rmsWindow = p.rmsWindow;
+            parameters.drive = p.drive;
+            parameters.filterType = settings.filterType;
+            parameters.drivePosition = settings.drivePosition;
+            parameters.detectorMode = settings.detector;
+
+            for (int source = 0; source < numModSources; ++source)
+                for (int destination = 0; destination < numModDestinations; ++destination)
+                    parameters.modAmounts[source][destination] = settings.modAmounts[source][destination];
+
+            auto* engine = envelopeEngineCreate(sampleRate, numChannels, controlInterval);
+
+            if (!expect(engine != nullptr, "%s: no engine", settings.name)) {
+                passed = false;
+                continue;
+            }
+
+            auto samples = makeInput();
+
+            for (int start = 0; start < numSamples; start += hostBlockSize) {
+                float* channels[numChannels];
+                for (int channel = 0; channel < numChannels; ++channel)
+                    channels[channel] = samples.data() + channel * numSamples + start;
+
+                passed &= expect(envelopeEngineProcess(engine, channels, std::min(hostBlockSize, numSamples - start), &parameters) == 0,
+                                 "%s: process failed", settings.name);
+            }
+
+            float* missing[numChannels] = {};
+            passed &= expect(envelopeEngineProcess(engine, missing, 1, &parameters) == -1, "processed a null channel");
+            passed &= expect(envelopeEngineProcess(engine, missing, 1, nullptr) == -1, "processed without parameters");
+
+            envelopeEngineDestroy(engine);
+
+            std::vector<float> golden;
+            passed &= expect(readGolden(goldenPath(goldenDirectory, settings), golden), "%s: no golden render", settings.name);
+
+            const auto difference = maxDifference(samples, golden);
+            std::printf("    %-36s max difference %.3g\n", settings.name, difference);
+            passed &= expect(difference <= tolerance, "%s: differs from the golden render by %g", settings.name, difference);
+        }
+
+        return passed;
+    }
+
+    int writeGoldens()
+    {
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            const auto path = ReferenceRenders::goldenPath(goldenDirectory, settings);
+
+            if (!ReferenceRenders::writeGolden(path, ReferenceRenders::renderWithEngine(settings))) {
+                std::printf("cannot write %s\n", path.c_str());
+                return 1;
+            }
+
+            std::printf("wrote %s\n", path.c_str());
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const CommandLine commandLine(argc, argv);
+
+    if (commandLine.hasOption("write-golden"))
+        return writeGoldens();
+
+    return runTests({
+        { "fast-math-bounds", fastMathBounds },
+        { "golden-renders", goldenRenders },
+        { "block-size-invariance", blockSizeInvariance },
+        { "channel-groups", channelGroups },
+        { "c-api", cApi },
+    }, commandLine);
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    PluginBenchmarks.cpp
+
+    Benchmarks that need JUCE. editor-open constructs and destroys
+    --opens editors (50 by default) against one prepared processor and
+    reports the time per open, with and without rendering the first frame.
+    The first open and paint builds the LookAndFeel and its fonts, which the
+    processor then keeps for every later open, so it is reported on its own.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "ReferenceRenders.h"
+#include "TestSupport.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    int numOpens = 50;
+
+    double openEditorMs(EnvelopeAudioProcessor& processor, bool paint)
+    {
+        const auto start = juce::Time::getMillisecondCounterHiRes();
+
+        {
+            std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditor());
+
+            // Renders the editor once into an image, as its first frame on screen would
+            if (paint) {
+                const auto frame = editor->createComponentSnapshot(editor->getLocalBounds());
+                juce::ignoreUnused(frame);
+            }
+        }
+
+        return juce::Time::getMillisecondCounterHiRes() - start;
+    }
+
+    bool editorOpen()
+    {
+        EnvelopeAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(ReferenceRenders::sampleRate, ReferenceRenders::hostBlockSize);
+        processor.prepareToPlay(ReferenceRenders::sampleRate, ReferenceRenders::hostBlockSize);
+
+        std::printf("    %-20s %8.3f ms\n", "first open and paint", openEditorMs(processor, true));
+
+        for (const auto paint : { false, true }) {
+            std::vector<double> times;
+
+            for (int i = 0; i < numOpens; ++i)
+                times.push_back(openEditorMs(processor, paint));
+
+            std::sort(times.begin(), times.end());
+            std::printf("    %-20s %8.3f ms median, %.3f ms best over %d opens\n",
+                        paint ? "later open and paint" : "later open", times[times.size() / 2], times.front(), numOpens);
+        }
+
+        processor.releaseResources();
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const CommandLine commandLine(argc, argv);
+    numOpens = juce::jmax(1, (int) commandLine.getOption("opens", 50.0));
+
+    return runTests({
+        { "editor-open", editorOpen },
+    }, commandLine);
+}
@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+    PluginTests.cpp
+
+    Headless tests of EnvelopeAudioProcessor: the golden renders through
+    processBlock(), the state blob round trip, the channel-group workers and
+    the cost per sample. No editor is created.
+
+  ==============================================================================
+*/
+
+#include "ChannelGroupPool.h"
+#include "PluginProcessor.h"
+#include "ReferenceRenders.h"
+#include "TestSupport.h"
+
+using namespace TestSupport;
+
+namespace
+{
+    const std::string goldenDirectory = ENVELOPE_GOLDEN_DIR;
+
+    std::unique_ptr<Baseline> baseline;
+
+    void applySettings(EnvelopeAudioProcessor& processor, const ReferenceRenders::Settings& settings)
+    {
+        ReferenceRenders::forEachParameter(settings, [&](const char* id, float value)
+            {
+                auto* parameter = processor.apvts.getParameter(id);
+                jassert(parameter != nullptr);
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+            });
+    }
+
+    /** Prepares the processor like a host would and renders the reference
+        input through processBlock() in blocks of blockSize.
+    */
+    std::vector<float> renderWithProcessor(EnvelopeAudioProcessor& processor, int blockSize = ReferenceRenders::hostBlockSize)
+    {
+        using namespace ReferenceRenders;
+
+        const auto input = makeInput();
+        juce::AudioBuffer<float> buffer(numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            buffer.copyFrom(channel, 0, input.data() + channel * numSamples, numSamples);
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        juce::MidiBuffer midi;
+
+        for (int start = 0; start < numSamples; start += blockSize) {
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, start, juce::jmin(blockSize, numSamples - start));
+            processor.processBlock(block, midi);
+        }
+
+        processor.releaseResources();
+
+        std::vector<float> output;
+        for (int channel = 0; channel < numChannels; ++channel)
+            output.insert(output.end(), buffer.getReadPointer(channel), buffer.getReadPointer(channel) + numSamples);
+
+        return output;
+    }
+
+    bool checkAgainstGolden(const ReferenceRenders::Settings& settings, const std::vector<float>& output)
+    {
+        std::vector<float> golden;
+
+        if (!expect(ReferenceRenders::readGolden(ReferenceRenders::goldenPath(goldenDirectory, settings), golden),
+                    "%s: no golden render", settings.name))
+            return false;
+
+        const auto difference = ReferenceRenders::maxDifference(output, golden);
+        std::printf("    %-36s max difference %.3g\n", settings.name, difference);
+
+        return expect(difference <= ReferenceRenders::tolerance, "%s: differs from the golden render by %g",
+                      settings.name, difference);
+    }
+
+    bool goldenRenders()
+    {
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            EnvelopeAudioProcessor processor;
+            applySettings(processor, settings);
+            passed &= checkAgainstGolden(settings, renderWithProcessor(processor));
+        }
+
+        return passed;
+    }
+
+    /** Hosts address automation by parameter index: the parameters of the
+        first release keep their places and new ones come after them.
+    */
+    bool parameterOrder()
+    {
+        const char* released[] = { "Gain", "Q", "Dry/Wet Mix", "Attack Time", "Release Time", "Band Start", "Band Width", "Bypass" };
+
+        EnvelopeAudioProcessor processor;
+        const auto& parameters = processor.getParameters();
+        bool passed = expect(parameters.size() >= juce::numElementsInArray(released), "only %d parameters", parameters.size());
+
+        for (int index = 0; passed && index < juce::numElementsInArray(released); ++index) {
+            const auto& id = dynamic_cast<juce::AudioProcessorParameterWithID&>(*parameters[index]).paramID;
+            passed &= expect(id == released[index], "parameter %d is %s, not %s", index, id.toRawUTF8(), released[index]);
+        }
+
+        return passed;
+    }
+
+    bool stateRoundTrip()
+    {
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            EnvelopeAudioProcessor source, restored;
+            applySettings(source, settings);
+
+            juce::MemoryBlock state;
+            source.getStateInformation(state);
+            restored.setStateInformation(state.getData(), (int) state.getSize());
+
+            for (auto* parameter : source.getParameters()) {
+                const auto& id = dynamic_cast<juce::AudioProcessorParameterWithID&>(*parameter).paramID;
+                auto* restoredParameter = restored.apvts.getParameter(id);
+
+                passed &= expect(restoredParameter != nullptr && restoredParameter->getValue() == parameter->getValue(),
+                                 "%s: %s was not restored", settings.name, id.toRawUTF8());
+            }
+
+            // The restored processor sounds like the one the state came from
+            passed &= checkAgainstGolden(settings, renderWithProcessor(restored));
+
+            // A blob of another plugin's state is ignored
+            juce::MemoryBlock foreignState;
+            {
+                juce::MemoryOutputStream stream(foreignState, false);
+                juce::ValueTree("SomeOtherPlugin").writeToStream(stream);
+            }
+
+            restored.setStateInformation(foreignState.getData(), (int) foreignState.getSize());
+            passed &= expect(restored.apvts.state.hasType(source.apvts.state.getType()),
+                             "%s: a foreign state replaced the parameters", settings.name);
+        }
+
+        return passed;
+    }
+
+    /** A 16-channel bus through ChannelGroupPool, in the groups of
+        ChannelStateBlock's run length processRealtime() splits it into,
+        renders bit for bit what the audio thread does alone.
+    */
+    bool channelGroupPool()
+    {
+        constexpr int busChannels = 16;
+        constexpr int channelsPerGroup = ChannelStateBlock<float>::runChannels;
+        constexpr int numWorkers = busChannels / channelsPerGroup - 1;
+
+        ChannelGroupPool pool(numWorkers);
+        bool passed = true;
+
+        for (const auto& settings : ReferenceRenders::getSettings()) {
+            const auto serial = ReferenceRenders::renderChannelGroups(settings, busChannels, busChannels,
+                [](int, auto& processGroup) { processGroup(0); });
+
+            const auto grouped = ReferenceRenders::renderChannelGroups(settings, busChannels, channelsPerGroup,
+                [&](int numGroups, auto& processGroup)
+                {
+                    // Let the workers pick the groups up, as they do once the
+                    // processor has switched the mode on
+                    pool.setActive(true);
+
+                    for (int wait = 0; !pool.isReady() && wait < 1000; ++wait)
+                        juce::Thread::sleep(1);
+
+                    pool.run(numGroups, processGroup);
+                });
+
+            const auto difference = ReferenceRenders::maxDifference(grouped, serial);
+            std::printf("    %-36s max difference %.3g\n", settings.name, difference);
+            passed &= expect(difference == 0.f, "%s: %d groups on the pool differ from the serial render",
+                             settings.name, busChannels / channelsPerGroup);
+        }
+
+        pool.setActive(false);
+        return passed;
+    }
+
+    bool nsPerSample()
+    {
+        using namespace ReferenceRenders;
+
+        constexpr int seconds = 1, repeats = 7;
+        bool passed = true;
+
+        for (const auto& settings : getSettings()) {
+            EnvelopeAudioProcessor processor;
+            applySettings(processor, settings);
+            processor.setRateAndBufferSizeDetails(sampleRate, hostBlockSize);
+            processor.prepareToPlay(sampleRate, hostBlockSize);
+
+            const auto input = makeInput();
+            juce::AudioBuffer<float> buffer(numChannels, hostBlockSize);
+            juce::MidiBuffer midi;
+            const auto numBlocks = (int) (seconds * sampleRate) / hostBlockSize;
+
+            const auto ns = bestTimeNs(repeats, [&]
+                {
+                    for (int block = 0; block < numBlocks; ++block) {
+                        const auto start = (block * hostBlockSize) % (numSamples - hostBlockSize);
+
+                        for (int channel = 0; channel < numChannels; ++channel)
+                            buffer.copyFrom(channel, 0, input.data() + channel * numSamples + start, hostBlockSize);
+
+                        processor.processBlock(buffer, midi);
+                    }
+                });
+
+            processor.releaseResources();
+
+            const auto nsPerSample = ns / ((double) numBlocks * hostBlockSize * numChannels);
+            std::printf("    %-36s %6.2f ns/sample\n", settings.name, nsPerSample);
+
+            passed &= baseline->check(settings.name, nsPerSample, "ns/sample");
+        }
+
+        return passed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    const CommandLine commandLine(argc, argv);
+    baseline = std::make_unique<Baseline>(commandLine);
+
+    return runTests({
+        { "golden-renders", goldenRenders },
+        { "parameter-order", parameterOrder },
+        { "state-round-trip", stateRoundTrip },
+        { "channel-group-pool", channelGroupPool },
+        { "ns-per-sample", nsPerSample },
+    }, commandLine);
+}
@@ -0,0 +1,356 @@
+/*
+  ==============================================================================
+
+    ReferenceRenders.h
+
+    Fixed input signal and reference parameter sets for the golden renders.
+    The goldens in Tests/Golden are the real-time output for each set, one
+    file per set, written by EnvelopeTests --write-golden and checked both
+    through the engine (EnvelopeTests) and through EnvelopeAudioProcessor
+    (EnvelopePluginTests), which must agree with the engine when velocity is
+    zero and no host timeline drives the LFO.
+
+    Settings are in the plugin's parameter units, so the plugin tests can set
+    them through the APVTS and the engine tests convert them the way
+    getChainSettings() does. Goldens are raw little-endian float32, channel
+    after channel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "EnvelopeEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ReferenceRenders
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+    constexpr int numSamples = 12000;
+    constexpr int hostBlockSize = 512;
+    constexpr int controlInterval = 32;
+    constexpr double hostBpm = 120.0;
+
+    // Covers libm differences between platforms, the APVTS snapping parameter
+    // values to their intervals and ENVELOPE_FAST_MATH builds, which stay
+    // within 6e-5. Far below any audible change.
+    constexpr float tolerance = 1.0e-4f;
+
+    struct Settings
+    {
+        const char* name = "";
+
+        float gain = 6.f, q = 3.f, mix = 1.f;
+        float attack = 0.001f, release = 0.080f, bandStart = 250.f, bandWidth = 1000.f;
+        float driveDb = 0.f, rmsWindow = 0.050f;
+        int filterType = 0, drivePosition = 0, detector = 0, lfoRate = 4;
+        float modAmounts[numModSources][numModDestinations]{ { 1.f, 0.f, 0.f } };
+
+        bool usesLfo() const noexcept
+        {
+            return modAmounts[modLfo][modCutoff] != 0.f || modAmounts[modLfo][modQ] != 0.f || modAmounts[modLfo][modGain] != 0.f;
+        }
+    };
+
+    /** One set per filter type, every detector mode and drive position, and
+        modulation of every destination. Values sit on the parameters' intervals.
+    */
+    inline std::vector<Settings> getSettings()
+    {
+        std::vector<Settings> sets;
+
+        {
+            Settings s;
+            s.name = "peak-default";
+            sets.push_back(s);
+        }
+        {
+            Settings s;
+            s.name = "peak-lfo-modulated";
+            s.gain = 12.f;
+            s.q = 2.f;
+            s.release = 0.150f;
+            s.lfoRate = 6;
+            s.modAmounts[modEnvelope][modQ] = 0.5f;
+            s.modAmounts[modEnvelope][modGain] = -0.5f;
+            s.modAmounts[modLfo][modCutoff] = 0.3f;
+            sets.push_back(s);
+        }
+        {
+            Settings s;
+            s.name = "ladder-lowpass-rms";
+            s.filterType = 2;
+            s.detector = 1;
+            s.rmsWindow = 0.020f;
+            s.gain = 4.f;
+            s.q = 6.f;
+            s.attack = 0.005f;
+            s.release = 0.200f;
+            s.bandStart = 150.f;
+            s.bandWidth = 3000.f;
+            sets.push_back(s);
+        }
+        {
+            Settings s;
+            s.name = "ladder-bandpass-truepeak-predrive";
+            s.filterType = 1;
+            s.detector = 2;
+            s.gain = 2.f;
+            s.q = 4.f;
+            s.driveDb = 12.f;
+            s.drivePosition = 1;
+            sets.push_back(s);
+        }
+        {
+            Settings s;
+            s.name = "svf-bandpass-postdrive";
+            s.filterType = 3;
+            s.q = 8.f;
+            s.mix = 0.7f;
+            s.driveDb = 18.f;
+            s.drivePosition = 2;
+            sets.push_back(s);
+        }
+        {
+            Settings s;
+            s.name = "svf-notch-halfmix";
+            s.filterType = 4;
+            s.q = 1.5f;
+            s.mix = 0.5f;
+            s.release = 0.350f;
+            s.bandStart = 400.f;
+            s.bandWidth = 6000.f;
+            s.detector = 1;
+            sets.push_back(s);
+        }
+
+        return sets;
+    }
+
+    /** The engine parameters getChainSettings() makes of the same values. */
+    inline EnvelopeParameters toEngineParameters(const Settings& s)
+    {
+        EnvelopeParameters p;
+
+        p.gainFactor = s.gain;
+        p.qFactor = s.q;
+        p.dryWetMix = s.mix;
+        p.attackTime = s.attack;
+        p.releaseTime = s.release;
+        p.bandStart = s.bandStart;
+        p.bandWidth = s.bandWidth;
+        p.rmsWindow = s.rmsWindow;
+        p.drive = std::pow(10.f, s.driveDb * 0.05f);
+        p.filterType = static_cast<FilterType>(s.filterType);
+        p.drivePosition = static_cast<DrivePosition>(s.drivePosition);
+        p.detectorMode = static_cast<DetectorMode>(s.detector);
+
+        for (int source = 0; source < numModSources; ++source)
+            for (int destination = 0; destination < numModDestinations; ++destination)
+                p.modMatrix.amounts[source][destination] = s.modAmounts[source][destination];
+
+        return p;
+    }
+
+    /** Calls callback(parameterId, value) for every plugin parameter. */
+    template <typename Callback>
+    void forEachParameter(const Settings& s, Callback&& callback)
+    {
+        callback("Gain", s.gain);
+        callback("Q", s.q);
+        callback("Filter Type", (float) s.filterType);
+        callback("Dry/Wet Mix", s.mix);
+        callback("Attack Time", s.attack);
+        callback("Release Time", s.release);
+        callback("Band Start", s.bandStart);
+        callback("Band Width", s.bandWidth);
+        callback("Drive", s.driveDb);
+        callback("Drive Position", (float) s.drivePosition);
+        callback("Detector", (float) s.detector);
+        callback("RMS Window", s.rmsWindow);
+        callback("LFO Rate", (float) s.lfoRate);
+
+        for (int source = 0; source < numModSources; ++source)
+            for (int destination = 0; destination < numModDestinations; ++destination)
+                callback(modAmountIds[source][destination], s.modAmounts[source][destination]);
+
+        callback("Bypass", 0.f);
+    }
+
+    /** Tone bursts every 100 ms, 60 ms long with 3 ms raised-cosine edges, so
+        every render runs through attacks and releases, over low-level noise
+        and hum. Deterministic, the noise is a hash of the sample index.
+    */
+    inline float input(int channel, int sample)
+    {
+        static constexpr double twoPi = 6.28318530717958647692;
+
+        const auto t = sample / sampleRate;
+        const auto inBurst = std::fmod(t, 0.1);
+        const auto edge = 0.003, length = 0.060;
+
+        auto gate = 0.0;
+
+        if (inBurst < edge)
+            gate = 0.5 - 0.5 * std::cos(twoPi * 0.5 * inBurst / edge);
+        else if (inBurst < length - edge)
+            gate = 1.0;
+        else if (inBurst < length)
+            gate = 0.5 + 0.5 * std::cos(twoPi * 0.5 * (inBurst - length + edge) / edge);
+
+        const auto tone = 0.6 * std::sin(twoPi * 220.0 * (1.0 + 0.01 * channel) * t)
+                        + 0.3 * std::sin(twoPi * 1375.0 * t + channel);
+
+        auto hash = (uint32_t) sample * 0x9e3779b1u ^ (uint32_t) (channel + 1) * 0x85ebca77u;
+        hash ^= hash >> 16;
+        hash *= 0x7feb352du;
+        hash ^= hash >> 15;
+        hash *= 0x846ca68bu;
+        hash ^= hash >> 16;
+        const auto noise = hash * (2.0 / 4294967296.0) - 1.0;
+
+        return (float) (gate * tone + 0.02 * noise + 0.01 * std::sin(twoPi * 50.0 * t));
+    }
+
+    /** The input of every channel, channel after channel. */
+    inline std::vector<float> makeInput()
+    {
+        std::vector<float> samples((size_t) (numChannels * numSamples));
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < numSamples; ++sample)
+                samples[(size_t) (channel * numSamples + sample)] = input(channel, sample);
+
+        return samples;
+    }
+
+    /** Renders the input through a real-time engine like processBlock() does,
+        in host blocks cycling through blockSizes.
+    */
+    inline std::vector<float> renderWithEngine(const Settings& settings, const std::vector<int>& blockSizes = { hostBlockSize })
+    {
+        auto samples = makeInput();
+        const auto parameters = toEngineParameters(settings);
+
+        EnvelopeEngine<float> engine;
+        engine.prepare(sampleRate, numChannels, controlInterval);
+
+        TempoSyncedLfo lfo;
+        lfo.prepare(sampleRate);
+
+        size_t nextSize = 0;
+
+        for (int start = 0; start < numSamples;) {
+            const auto blockSize = std::min(blockSizes[nextSize++ % blockSizes.size()], numSamples - start);
+
+            float* channels[numChannels];
+            for (int channel = 0; channel < numChannels; ++channel)
+                channels[channel] = samples.data() + channel * numSamples + start;
+
+            lfo.setRate(lfoRateBeats[settings.lfoRate], hostBpm);
+            engine.process(channels, blockSize, parameters, { &lfo, 0.f });
+            lfo.advance(blockSize);
+
+            start += blockSize;
+        }
+
+        return samples;
+    }
+
+    /** Renders settings over a bus of busChannels, channel c fed the input
+        of reference channel c % numChannels scaled a little per channel,
+        like processRealtime() does: the block is split into groups of
+        channelsPerGroup channels and runGroups(numGroups, processGroup) must
+        call processGroup(group) once for every group in [0, numGroups).
+    */
+    template <typename RunGroups>
+    std::vector<float> renderChannelGroups(const Settings& settings, int busChannels, int channelsPerGroup, RunGroups&& runGroups)
+    {
+        std::vector<float> samples((size_t) (busChannels * numSamples));
+
+        for (int channel = 0; channel < busChannels; ++channel)
+            for (int sample = 0; sample < numSamples; ++sample)
+                samples[(size_t) (channel * numSamples + sample)] = (1.f - 0.03f * (float) channel) * input(channel % numChannels, sample);
+
+        const auto parameters = toEngineParameters(settings);
+
+        EnvelopeEngine<float> engine;
+        engine.prepare(sampleRate, busChannels, controlInterval);
+
+        TempoSyncedLfo lfo;
+        lfo.prepare(sampleRate);
+
+        const auto numGroups = (busChannels + channelsPerGroup - 1) / channelsPerGroup;
+        std::vector<float*> channels((size_t) busChannels);
+
+        for (int start = 0; start < numSamples; start += hostBlockSize) {
+            const auto blockSize = std::min(hostBlockSize, numSamples - start);
+
+            for (int channel = 0; channel < busChannels; ++channel)
+                channels[(size_t) channel] = samples.data() + channel * numSamples + start;
+
+            lfo.setRate(lfoRateBeats[settings.lfoRate], hostBpm);
+            const ModulationSources sources{ &lfo, 0.f };
+
+            auto processGroup = [&](int group)
+                {
+                    const auto firstChannel = group * channelsPerGroup;
+                    const auto lastChannel = std::min(busChannels, firstChannel + channelsPerGroup);
+                    engine.processChannels(channels.data(), blockSize, 0, firstChannel, lastChannel, parameters, sources);
+                };
+
+            engine.beginBlock(parameters);
+            runGroups(numGroups, processGroup);
+            engine.endBlock(blockSize);
+
+            lfo.advance(blockSize);
+        }
+
+        return samples;
+    }
+
+    inline std::string goldenPath(const std::string& directory, const Settings& settings)
+    {
+        return directory + "/" + settings.name + ".f32";
+    }
+
+    inline bool readGolden(const std::string& path, std::vector<float>& samples)
+    {
+        std::ifstream in(path, std::ios::binary);
+        samples.assign((size_t) (numChannels * numSamples), 0.f);
+
+        return in.read(reinterpret_cast<char*>(samples.data()), (std::streamsize) (samples.size() * sizeof(float)))
+            && in.peek() == std::ifstream::traits_type::eof();
+    }
+
+    inline bool writeGolden(const std::string& path, const std::vector<float>& samples)
+    {
+        std::ofstream out(path, std::ios::binary);
+        return (bool) out.write(reinterpret_cast<const char*>(samples.data()), (std::streamsize) (samples.size() * sizeof(float)));
+    }
+
+    /** Largest absolute difference, infinite if the sizes differ or a sample is not finite. */
+    inline float maxDifference(const std::vector<float>& a, const std::vector<float>& b)
+    {
+        if (a.size() != b.size())
+            return INFINITY;
+
+        float largest = 0.f;
+
+        for (size_t i = 0; i < a.size(); ++i) {
+            const auto difference = std::abs(a[i] - b[i]);
+
+            if (!(difference <= largest))
+                largest = std::isfinite(difference) ? difference : INFINITY;
+        }
+
+        return largest;
+    }
+}
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    TestSupport.h
+
+    What the test and benchmark executables share: a list of named tests run
+    from the command line, expectations that report and carry on, and a
+    best-of-N timer. No framework, the JUCE-free targets stay free of it.
+
+    Every executable takes the names of the tests to run, all of them if none
+    is given, and options of the form --name=value.
+
+    Timings are gated against a baseline measured on the same machine rather
+    than against absolute numbers: --baseline=file names it and
+    --threshold=ratio (1.15 by default) is how much slower a measurement may
+    be. Entries the file does not have yet are recorded, --write-baseline
+    records every measurement afresh.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TestSupport
+{
+    struct TestCase
+    {
+        const char* name;
+        std::function<bool()> run;
+    };
+
+    class CommandLine
+    {
+    public:
+        CommandLine(int argc, char* argv[])
+        {
+            for (int i = 1; i < argc; ++i) {
+                if (std::strncmp(argv[i], "--", 2) == 0)
+                    options.emplace_back(argv[i] + 2);
+                else
+                    names.emplace_back(argv[i]);
+            }
+        }
+
+        /** The value of --name=value, or fallback if it was not given. */
+        std::string getOption(const char* name, const char* fallback = "") const
+        {
+            const auto prefix = std::string(name) + "=";
+
+            for (const auto& option : options)
+                if (option.compare(0, prefix.size(), prefix) == 0)
+                    return option.substr(prefix.size());
+
+            return fallback;
+        }
+
+        double getOption(const char* name, double fallback) const
+        {
+            const auto value = getOption(name);
+            return value.empty() ? fallback : std::atof(value.c_str());
+        }
+
+        /** True if --name was given, with or without a value. */
+        bool hasOption(const char* name) const
+        {
+            const auto prefix = std::string(name) + "=";
+
+            return std::any_of(options.begin(), options.end(), [&](const std::string& option)
+                { return option == name || option.compare(0, prefix.size(), prefix) == 0; });
+        }
+
+        std::vector<std::string> names, options;
+    };
+
+    /** Prints the message and returns false if condition does not hold. */
+    inline bool expect(bool condition, const char* format, ...)
+    {
+        if (!condition) {
+            va_list args;
+            va_start(args, format);
+            std::printf("    failed: ");
+            std::vprintf(format, args);
+            std::printf("\n");
+            va_end(args);
+        }
+
+        return condition;
+    }
+
+    /** Runs the tests named on the command line, or all of them, and returns
+        the exit code: 0 once every test that ran has passed.
+    */
+    inline int runTests(const std::vector<TestCase>& tests, const CommandLine& commandLine)
+    {
+        for (const auto& name : commandLine.names) {
+            if (std::none_of(tests.begin(), tests.end(), [&](const TestCase& test) { return name == test.name; })) {
+                std::printf("unknown test %s\n", name.c_str());
+                return 2;
+            }
+        }
+
+        int failures = 0;
+
+        for (const auto& test : tests) {
+            const auto& names = commandLine.names;
+
+            if (!names.empty() && std::find(names.begin(), names.end(), test.name) == names.end())
+                continue;
+
+            std::printf("%s\n", test.name);
+            std::fflush(stdout);
+
+            const auto passed = test.run();
+            std::printf("  %s\n", passed ? "passed" : "FAILED");
+            std::fflush(stdout);
+
+            failures += passed ? 0 : 1;
+        }
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    /** Timings of one machine, one "name value" line per entry, that later
+        runs are compared against.
+    */
+    class Baseline
+    {
+    public:
+        /** Reads the file --baseline names. Without one, check() only reports. */
+        explicit Baseline(const CommandLine& commandLine)
+            : path(commandLine.getOption("baseline")),
+              threshold(commandLine.getOption("threshold", 1.15)),
+              rewrite(commandLine.hasOption("write-baseline"))
+        {
+            std::ifstream in(path);
+            std::string name;
+            double value;
+
+            while (in >> name >> value)
+                entries[name] = value;
+        }
+
+        /** False if value is more than the threshold times the baseline of
+            name. A name the baseline has no entry for is recorded and passes.
+        */
+        bool check(const std::string& name, double value, const char* unit)
+        {
+            if (path.empty())
+                return true;
+
+            const auto entry = entries.find(name);
+
+            if (rewrite || entry == entries.end()) {
+                entries[name] = value;
+                return expect(save(), "cannot write the baseline %s", path.c_str());
+            }
+
+            const auto ratio = value / entry->second;
+            std::printf("    %-36s %6.2fx the baseline of %.2f %s\n", name.c_str(), ratio, entry->second, unit);
+
+            return expect(ratio <= threshold, "%s: %.2f %s is %.2fx the baseline, over the threshold of %.2fx",
+                          name.c_str(), value, unit, ratio, threshold);
+        }
+
+    private:
+        std::string path;
+        double threshold;
+        bool rewrite;
+        std::map<std::string, double> entries;
+
+        bool save() const
+        {
+            std::ofstream out(path);
+
+            for (const auto& entry : entries)
+                out << entry.first << ' ' << entry.second << '\n';
+
+            return (bool) out;
+        }
+    };
+
+    /** Fastest of repeats runs of callback in nanoseconds. The fastest run is
+        the one the rest of the machine disturbed least.
+    */
+    template <typename Callback>
+    double bestTimeNs(int repeats, Callback&& callback)
+    {
+        using Clock = std::chrono::steady_clock;
+        double best = 0.0;
+
+        for (int i = 0; i < repeats; ++i) {
+            const auto start = Clock::now();
+            callback();
+            const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+            best = (i == 0 || elapsed < best) ? elapsed : best;
+        }
+
+        return best;
+    }
+}
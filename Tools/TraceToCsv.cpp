@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    TraceToCsv.cpp
+
+    Converts a trace written by TraceRecorder (format in Source/Trace.h) to
+    CSV, one row per control tick. Plain C++17, the TraceToCsv target of the
+    CMake build or on its own:
+
+        c++ -std=c++17 -O2 Tools/TraceToCsv.cpp -o TraceToCsv
+        ./TraceToCsv Envelope-trace-20260101-120000.envtrace > trace.csv
+
+    Without an output file the CSV goes to stdout.
+
+  ==============================================================================
+*/
+
+#include "../Source/FilterPolicies.h"
+#include "../Source/LevelDetector.h"
+#include "../Source/Saturation.h"
+#include "../Source/Trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Choices are stored by index and named from the tables the plugin's
+    // parameters are built from
+    template <size_t size>
+    const char* nameOf(const char* const (&names)[size], uint8_t index)
+    {
+        return index < size ? names[index] : "?";
+    }
+
+    void writeCsv(std::ostream& out, const std::vector<TraceRecord>& records)
+    {
+        out << "block,block_start_ms,previous_block_ms,block_size,tick_offset,dropped,"
+               "envelope,cutoff,q,gain,"
+               "gain_factor,q_factor,band_start,band_width,attack_time,release_time,dry_wet_mix,drive,"
+               "filter_type,detector,drive_position,offline\n";
+
+        char line[512];
+
+        for (const auto& r : records) {
+            std::snprintf(line, sizeof(line),
+                          "%llu,%.6f,%.6f,%u,%u,%u,"
+                          "%.9g,%.9g,%.9g,%.9g,"
+                          "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,"
+                          "%s,%s,%s,%u\n",
+                          (unsigned long long) r.blockIndex, (double) r.blockStartNs * 1.0e-6, r.previousBlockNs * 1.0e-6,
+                          r.blockSize, r.tickOffset, r.droppedRecords,
+                          r.envelope, r.cutoff, r.q, r.gain,
+                          r.gainFactor, r.qFactor, r.bandStart, r.bandWidth, r.attackTime, r.releaseTime, r.dryWetMix, r.drive,
+                          nameOf(filterTypeNames, r.filterType), nameOf(detectorModeNames, r.detectorMode),
+                          nameOf(drivePositionNames, r.drivePosition), (unsigned) r.offline);
+            out << line;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "usage: " << argv[0] << " <trace file> [csv file]\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios::binary);
+
+    if (!in) {
+        std::cerr << "cannot open " << argv[1] << "\n";
+        return 1;
+    }
+
+    TraceFileHeader header;
+
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, TraceFileHeader::expectedMagic, sizeof(header.magic)) != 0) {
+        std::cerr << argv[1] << " is not an envelope trace\n";
+        return 1;
+    }
+
+    if (header.version != TraceFileHeader::currentVersion || header.recordSize != sizeof(TraceRecord)) {
+        std::cerr << "unsupported trace version " << header.version << " with " << header.recordSize << " byte records\n";
+        return 1;
+    }
+
+    // A trace cut short by a crash may hold fewer records than the header
+    // promises, or more zeroed ones from the last chunk: trust neither
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+
+    while (records.size() < header.numRecords && in.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        records.push_back(record);
+
+    if (records.size() < header.numRecords)
+        std::cerr << "warning: expected " << header.numRecords << " records, found " << records.size() << "\n";
+
+    if (argc == 3) {
+        std::ofstream out(argv[2]);
+
+        if (!out) {
+            std::cerr << "cannot write " << argv[2] << "\n";
+            return 1;
+        }
+
+        writeCsv(out, records);
+    }
+    else {
+        writeCsv(std::cout, records);
+    }
+
+    return 0;
+}